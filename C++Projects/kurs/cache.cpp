@@ -0,0 +1,178 @@
+#include "cache.h"
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const uint8_t* ptr) {
+    uint64_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t mergeRound64(uint64_t acc, uint64_t value) {
+    acc ^= round64(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Эталонный алгоритм XXH64 (порядок байт - как у хоста, как и в протоколе)
+uint64_t xxHash64(const void* data, size_t length, uint64_t seed) {
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    const uint8_t* end = ptr + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(ptr));
+            v2 = round64(v2, read64(ptr + 8));
+            v3 = round64(v3, read64(ptr + 16));
+            v4 = round64(v4, read64(ptr + 24));
+            ptr += 32;
+        } while (ptr <= limit);
+
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = mergeRound64(hash, v1);
+        hash = mergeRound64(hash, v2);
+        hash = mergeRound64(hash, v3);
+        hash = mergeRound64(hash, v4);
+    } else {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += static_cast<uint64_t>(length);
+
+    while (ptr + 8 <= end) {
+        hash ^= round64(0, read64(ptr));
+        hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+        ptr += 8;
+    }
+    if (ptr + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read32(ptr)) * PRIME64_1;
+        hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+        ptr += 4;
+    }
+    while (ptr < end) {
+        hash ^= static_cast<uint64_t>(*ptr) * PRIME64_5;
+        hash = rotl64(hash, 11) * PRIME64_1;
+        ptr++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+double CacheStats::hitRate() const {
+    uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+}
+
+ResultCache::ResultCache() : hits(0), misses(0), insertions(0), evictions(0) {}
+
+void ResultCache::configure(size_t capacity, size_t numShards) {
+    shards.clear();
+    if (capacity == 0) return;
+
+    if (numShards == 0) numShards = 1;
+    if (numShards > capacity) numShards = capacity;
+
+    for (size_t i = 0; i < numShards; i++) {
+        std::unique_ptr<Shard> shard(new Shard);
+        shard->capacity = capacity / numShards + (i < capacity % numShards ? 1 : 0);
+        shards.push_back(std::move(shard));
+    }
+}
+
+bool ResultCache::enabled() const {
+    return !shards.empty();
+}
+
+ResultCache::Shard& ResultCache::shardFor(const Key& key) {
+    // Старшие биты хеша - чтобы выбор шарда не коррелировал с бакетами внутри шарда
+    return *shards[(key.hash >> 48) % shards.size()];
+}
+
+bool ResultCache::lookup(uint64_t hash, uint32_t length, uint16_t& sum) {
+    if (shards.empty()) {
+        misses++;
+        return false;
+    }
+
+    Key key = {hash, length};
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses++;
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    sum = it->second->sum;
+    hits++;
+    return true;
+}
+
+void ResultCache::insert(uint64_t hash, uint32_t length, uint16_t sum) {
+    if (shards.empty()) return;
+
+    Key key = {hash, length};
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->sum = sum;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    if (shard.lru.size() >= shard.capacity) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        evictions++;
+    }
+
+    Entry entry = {key, sum};
+    shard.lru.push_front(entry);
+    shard.index[key] = shard.lru.begin();
+    insertions++;
+}
+
+CacheStats ResultCache::stats() const {
+    CacheStats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.insertions = insertions;
+    result.evictions = evictions;
+    return result;
+}
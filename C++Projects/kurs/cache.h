@@ -0,0 +1,76 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+// Расширение протокола: старший бит в размере вектора означает, что за размером
+// следует uint64 xxHash содержимого. Сервер отвечает одним байтом: CACHE_HIT - сумма
+// уже известна и данные не передаются, CACHE_MISS - клиент досылает вектор целиком.
+const uint32_t HASH_OFFER_FLAG = 0x80000000u;
+const char CACHE_HIT = 'H';
+const char CACHE_MISS = 'M';
+
+// 64-битный xxHash (XXH64) - им клиент и сервер адресуют содержимое вектора.
+// Хеш быстрый, но не криптографический: кэш рассчитан на доверенных клиентов
+uint64_t xxHash64(const void* data, size_t length, uint64_t seed = 0);
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+
+    double hitRate() const;
+};
+
+// Ограниченный LRU-кэш сумм векторов по ключу (хеш, длина), разбитый на шарды
+// с отдельными мьютексами, чтобы параллельные обращения не упирались в одну блокировку
+class ResultCache {
+private:
+    struct Key {
+        uint64_t hash;
+        uint32_t length;
+        bool operator==(const Key& other) const { return hash == other.hash && length == other.length; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash ^ (static_cast<uint64_t>(key.length) << 32); }
+    };
+
+    struct Entry {
+        Key key;
+        uint16_t sum;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t capacity = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> insertions;
+    std::atomic<uint64_t> evictions;
+
+    Shard& shardFor(const Key& key);
+
+public:
+    ResultCache();
+    void configure(size_t capacity, size_t numShards = 16);
+    bool enabled() const;
+    bool lookup(uint64_t hash, uint32_t length, uint16_t& sum);
+    void insert(uint64_t hash, uint32_t length, uint16_t sum);
+    CacheStats stats() const;
+};
+
+#endif
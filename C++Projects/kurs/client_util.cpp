@@ -0,0 +1,46 @@
+#include "client_util.h"
+#include <algorithm>
+#include <sys/socket.h>
+#include <cryptopp/sha.h>
+#include <cryptopp/hex.h>
+
+namespace CPP = CryptoPP;
+
+bool sendAll(int sock, const void* data, size_t len) {
+    const char* ptr = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t sent = send(sock, ptr, len, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        ptr += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+bool recvAll(int sock, void* data, size_t len) {
+    return recv(sock, data, len, MSG_WAITALL) == static_cast<ssize_t>(len);
+}
+
+std::string buildAuthFrame(const std::string& login, const std::string& password,
+                           std::mt19937_64& rng, bool wide) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string salt(16, '0');
+    for (char& c : salt) c = HEX[rng() % 16];
+
+    std::string hash;
+    CPP::SHA224 sha224;
+    CPP::StringSource(salt + password, true,
+        new CPP::HashFilter(sha224,
+            new CPP::HexEncoder(
+                new CPP::StringSink(hash))));
+
+    std::string frameLogin = login;
+    if (wide || login != "user") frameLogin.resize(8, ' ');
+    return frameLogin + salt + hash;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
@@ -0,0 +1,24 @@
+#ifndef CLIENT_UTIL_H
+#define CLIENT_UTIL_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstddef>
+
+// Общие части клиентов протокола: координатора, loadgen, replay и тестов
+
+// Блокирующие отправка и приём ровно len байт; разрыв соединения не вызывает SIGPIPE
+bool sendAll(int sock, const void* data, size_t len);
+bool recvAll(int sock, void* data, size_t len);
+
+// 76 байт: "user" + соль(16) + хеш(56); 80 байт: логин(8, дополнен пробелами) + соль(16) + хеш(56).
+// Другие логины сервер разбирает только в 80-байтовом формате, поэтому wide для них не важен.
+// Соль - 16 случайных шестнадцатеричных цифр, хеш - SHA224(соль + пароль) в верхнем регистре
+std::string buildAuthFrame(const std::string& login, const std::string& password,
+                           std::mt19937_64& rng, bool wide = false);
+
+// Перцентиль p (0..1) отсортированной выборки, 0 для пустой
+double percentile(const std::vector<double>& sorted, double p);
+
+#endif
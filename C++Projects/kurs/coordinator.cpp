@@ -0,0 +1,383 @@
+#include "coordinator.h"
+#include "server.h"
+#include "client_util.h"
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static bool connectWithTimeout(int sock, const sockaddr_in& addr, uint32_t timeoutMs) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    int rc = connect(sock, (const sockaddr*)&addr, sizeof(addr));
+    if (rc < 0 && errno == EINPROGRESS) {
+        pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLOUT;
+        if (poll(&pfd, 1, timeoutMs) != 1) return false;
+
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) return false;
+        rc = 0;
+    }
+    fcntl(sock, F_SETFL, flags);
+    return rc == 0;
+}
+
+ShardCoordinator::ShardCoordinator() : logger(nullptr), stopping(false) {}
+
+ShardCoordinator::~ShardCoordinator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (healthThread.joinable()) healthThread.join();
+}
+
+bool ShardCoordinator::configure(const CoordinatorParams& p, Logger* log) {
+    params = p;
+    logger = log;
+    backends.clear();
+
+    if (params.shardSize == 0) {
+        logger->logError("Shard size must be positive", true);
+        return false;
+    }
+    if (params.maxInflight == 0) {
+        logger->logError("Backend in-flight limit must be positive", true);
+        return false;
+    }
+
+    for (const std::string& address : params.backends) {
+        size_t pos = address.find_last_of(':');
+        if (pos == std::string::npos) {
+            logger->logError("Invalid backend address (expected host:port): " + address, true);
+            return false;
+        }
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* info = nullptr;
+        if (getaddrinfo(address.substr(0, pos).c_str(), address.substr(pos + 1).c_str(), &hints, &info) != 0) {
+            logger->logError("Cannot resolve backend: " + address, true);
+            return false;
+        }
+
+        Backend backend;
+        backend.name = address;
+        std::memcpy(&backend.addr, info->ai_addr, sizeof(backend.addr));
+        freeaddrinfo(info);
+        backends.push_back(backend);
+    }
+
+    if (backends.empty()) return true;
+
+    size_t healthy = checkHealth();
+    logger->logInfo("Coordinator mode: " + std::to_string(healthy) + " of " +
+                    std::to_string(backends.size()) + " backends healthy, shard size " +
+                    std::to_string(params.shardSize));
+
+    healthThread = std::thread(&ShardCoordinator::healthLoop, this);
+    return true;
+}
+
+bool ShardCoordinator::enabled() const {
+    return !backends.empty();
+}
+
+uint32_t ShardCoordinator::shardSize() const {
+    return params.shardSize;
+}
+
+// Одна полная сессия с бэкендом: аутентификация, один вектор, одна сумма
+bool ShardCoordinator::querySum(Attempt& attempt, const uint16_t* data, uint32_t size, uint16_t& result) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (attempt.cancelled) {
+            close(sock);
+            return false;
+        }
+        attempt.fd = sock;
+    }
+
+    timeval timeout;
+    timeout.tv_sec = params.timeoutMs / 1000;
+    timeout.tv_usec = (params.timeoutMs % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    bool ok = connectWithTimeout(sock, backends[attempt.backend].addr, params.timeoutMs);
+
+    if (ok) {
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        std::string authFrame = buildAuthFrame(params.login, params.password, rng);
+        char reply[2];
+        ok = sendAll(sock, authFrame.data(), authFrame.size()) &&
+             recvAll(sock, reply, sizeof(reply)) && std::strncmp(reply, "OK", 2) == 0;
+    }
+
+    if (ok) {
+        uint32_t header[2] = {1, size};
+        uint32_t numResults = 0;
+        ok = sendAll(sock, header, sizeof(header)) &&
+             sendAll(sock, data, size * sizeof(uint16_t)) &&
+             recvAll(sock, &numResults, sizeof(numResults)) && numResults == 1 &&
+             recvAll(sock, &result, sizeof(result));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        attempt.fd = -1;
+    }
+    close(sock);
+    return ok;
+}
+
+// Свободный бэкенд, которому этот шард ещё не отправлялся. Если таких не осталось
+// и allowRepeat, подходит уже испробованный, на котором шард сейчас не выполняется
+// (repeat). Пока есть здоровые кандидаты, нездоровые не рассматриваются.
+// exhausted - кандидатов не осталось вовсе.
+int ShardCoordinator::pickBackend(const std::vector<std::unique_ptr<Attempt>>& attempts, size_t shard,
+                                  bool allowRepeat, bool& exhausted, bool& repeat) {
+    std::vector<bool> tried(backends.size(), false);
+    std::vector<bool> running(backends.size(), false);
+    for (const std::unique_ptr<Attempt>& attempt : attempts) {
+        if (attempt->shard != shard) continue;
+        tried[attempt->backend] = true;
+        if (!attempt->finished) running[attempt->backend] = true;
+    }
+
+    repeat = std::find(tried.begin(), tried.end(), false) == tried.end();
+    std::vector<bool> candidate(backends.size(), false);
+    for (size_t i = 0; i < backends.size(); i++) {
+        candidate[i] = repeat ? allowRepeat && !running[i] : !tried[i];
+    }
+
+    bool anyCandidate = false;
+    bool anyHealthy = false;
+    for (size_t i = 0; i < backends.size(); i++) {
+        if (!candidate[i]) continue;
+        anyCandidate = true;
+        if (backends[i].healthy) anyHealthy = true;
+    }
+    exhausted = !anyCandidate;
+
+    int best = -1;
+    for (size_t i = 0; i < backends.size(); i++) {
+        size_t index = (shard + i) % backends.size();
+        const Backend& backend = backends[index];
+        if (!candidate[index] || (anyHealthy && !backend.healthy) || backend.inflight >= params.maxInflight) continue;
+        if (best < 0 || backend.inflight < backends[best].inflight) best = index;
+    }
+    return best;
+}
+
+void ShardCoordinator::launch(std::vector<std::unique_ptr<Attempt>>& attempts, std::vector<Shard>& shards,
+                              size_t shard, size_t backend) {
+    std::unique_ptr<Attempt> attempt(new Attempt);
+    attempt->shard = shard;
+    attempt->backend = backend;
+    backends[backend].inflight++;
+    shards[shard].tries++;
+
+    Attempt* raw = attempt.get();
+    const uint16_t* data = shards[shard].data;
+    uint32_t size = shards[shard].size;
+    attempts.push_back(std::move(attempt));
+
+    raw->thread = std::thread([this, raw, data, size]() {
+        uint16_t result = 0;
+        bool ok = querySum(*raw, data, size, result);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            raw->finished = true;
+            raw->ok = ok;
+            raw->result = result;
+            backends[raw->backend].inflight--;
+        }
+        changed.notify_all();
+    });
+}
+
+void ShardCoordinator::cancelShard(std::vector<std::unique_ptr<Attempt>>& attempts, size_t shard) {
+    for (std::unique_ptr<Attempt>& attempt : attempts) {
+        if (attempt->shard != shard || attempt->finished) continue;
+        attempt->cancelled = true;
+        if (attempt->fd >= 0) shutdown(attempt->fd, SHUT_RDWR);
+    }
+}
+
+// Вызывается под mutex
+void ShardCoordinator::setHealthy(size_t backend, bool healthy) {
+    if (backends[backend].healthy == healthy) return;
+    backends[backend].healthy = healthy;
+    if (healthy) {
+        logger->logInfo("Backend is back online: " + backends[backend].name);
+    } else {
+        logger->logError("Backend marked unhealthy: " + backends[backend].name);
+    }
+}
+
+size_t ShardCoordinator::checkHealth() {
+    static const uint16_t probe = 1;
+    size_t healthy = 0;
+
+    for (size_t i = 0; i < backends.size(); i++) {
+        Attempt attempt;
+        attempt.backend = i;
+        uint16_t result = 0;
+        bool ok = querySum(attempt, &probe, 1, result) && result == probe;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        setHealthy(i, ok);
+        if (ok) healthy++;
+    }
+    return healthy;
+}
+
+void ShardCoordinator::healthLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        Clock::time_point due = Clock::now() + std::chrono::milliseconds(params.healthIntervalMs);
+        if (changed.wait_until(lock, due, [this]() { return stopping; })) break;
+
+        lock.unlock();
+        checkHealth();
+        lock.lock();
+    }
+}
+
+bool ShardCoordinator::distribute(const std::vector<uint16_t>& vector, std::vector<uint16_t>& partials) {
+    size_t total = vector.size();
+    size_t numShards = (total + params.shardSize - 1) / params.shardSize;
+    numShards = std::max(numShards, std::min(backends.size(), total));
+    if (numShards == 0) return false;
+
+    std::vector<Shard> shards(numShards);
+    size_t offset = 0;
+    for (size_t i = 0; i < numShards; i++) {
+        shards[i].data = vector.data() + offset;
+        shards[i].size = total / numShards + (i < total % numShards ? 1 : 0);
+        offset += shards[i].size;
+    }
+
+    std::vector<std::unique_ptr<Attempt>> attempts;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    size_t remaining = numShards;
+    bool failed = false;
+    while (remaining > 0 && !failed) {
+        for (size_t i = 0; i < attempts.size() && !failed; i++) {
+            Attempt& attempt = *attempts[i];
+            if (!attempt.finished || !attempt.thread.joinable()) continue;
+            attempt.thread.join();
+
+            Shard& shard = shards[attempt.shard];
+            if (attempt.ok) {
+                setHealthy(attempt.backend, true);
+                if (!shard.done) {
+                    shard.done = true;
+                    shard.result = attempt.result;
+                    remaining--;
+                    cancelShard(attempts, attempt.shard);
+                }
+                continue;
+            }
+
+            if (attempt.cancelled || shard.done) continue;
+            setHealthy(attempt.backend, false);
+
+            bool inflight = false;
+            for (const std::unique_ptr<Attempt>& other : attempts) {
+                if (other->shard == attempt.shard && !other->finished) inflight = true;
+            }
+            uint32_t budget = 1 + params.retries + (shard.hedged ? 1 : 0);
+            if (!inflight) {
+                shard.pending = true;
+                shard.retryAt = Clock::now() + std::chrono::milliseconds(params.retryBackoffMs * shard.tries);
+                failed = shard.tries >= budget;
+            }
+        }
+        if (remaining == 0 || failed) break;
+
+        // Ожидающие шарды получают свободные бэкенды в порядке очереди.
+        // Отсчёт до дублирования начинается с фактической отправки шарда.
+        Clock::time_point now = Clock::now();
+        Clock::time_point wake = now + std::chrono::milliseconds(100);
+        bool queued = false;
+        for (size_t i = 0; i < numShards && !failed; i++) {
+            Shard& shard = shards[i];
+            if (shard.done || !shard.pending) continue;
+
+            bool exhausted = false;
+            bool repeat = false;
+            int backend = pickBackend(attempts, i, true, exhausted, repeat);
+            if (backend < 0 || (repeat && shard.retryAt > now)) {
+                failed = exhausted;
+                queued = true;
+                if (repeat) wake = std::min(wake, shard.retryAt);
+                continue;
+            }
+            shard.pending = false;
+            shard.started = now;
+            launch(attempts, shards, i, backend);
+        }
+        if (failed) break;
+
+        // Шард без ответа дольше hedgeMs дублируется, но только на свободный бэкенд
+        // и только когда в очереди не осталось шардов, ещё не отправленных ни разу
+        for (size_t i = 0; i < numShards && !queued && params.hedgeMs > 0; i++) {
+            Shard& shard = shards[i];
+            if (shard.done || shard.pending || shard.hedged) continue;
+            Clock::time_point hedgeAt = shard.started + std::chrono::milliseconds(params.hedgeMs);
+            if (hedgeAt > now) {
+                wake = std::min(wake, hedgeAt);
+                continue;
+            }
+            bool exhausted = false;
+            bool repeat = false;
+            int backend = pickBackend(attempts, i, false, exhausted, repeat);
+            if (backend >= 0) {
+                launch(attempts, shards, i, backend);
+                shard.hedged = true;
+            }
+        }
+
+        changed.wait_until(lock, wake);
+    }
+
+    for (size_t i = 0; i < numShards; i++) {
+        cancelShard(attempts, i);
+    }
+    lock.unlock();
+
+    for (std::unique_ptr<Attempt>& attempt : attempts) {
+        if (attempt->thread.joinable()) attempt->thread.join();
+    }
+
+    if (failed) return false;
+
+    partials.clear();
+    for (const Shard& shard : shards) {
+        partials.push_back(shard.result);
+    }
+    return true;
+}
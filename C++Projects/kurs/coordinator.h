@@ -0,0 +1,95 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <netinet/in.h>
+
+class Logger;
+
+struct CoordinatorParams {
+    std::vector<std::string> backends;
+    std::string login = "user";
+    std::string password = "P@ssW0rd";
+    uint32_t shardSize = 1000000;
+    uint32_t retries = 2;
+    uint32_t retryBackoffMs = 50;
+    uint32_t hedgeMs = 50;
+    uint32_t maxInflight = 1;
+    uint32_t timeoutMs = 2000;
+    uint32_t healthIntervalMs = 1000;
+};
+
+// Раздаёт диапазоны большого вектора серверам-бэкендам по обычному протоколу
+// и собирает частичные суммы. Бэкенд обслуживает соединения по одному, поэтому
+// на него одновременно отправляется не больше maxInflight шардов, остальные ждут.
+// Медленный шард дублируется (hedged request) на свободный бэкенд, упавший -
+// повторяется на следующем, а когда все бэкенды уже испробованы - на них же
+// повторно, с паузой retryBackoffMs * номер попытки.
+class ShardCoordinator {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Backend {
+        std::string name;
+        sockaddr_in addr;
+        bool healthy = true;
+        uint32_t inflight = 0;
+    };
+
+    struct Attempt {
+        size_t shard = 0;
+        size_t backend = 0;
+        int fd = -1;
+        bool finished = false;
+        bool cancelled = false;
+        bool ok = false;
+        uint16_t result = 0;
+        std::thread thread;
+    };
+
+    struct Shard {
+        const uint16_t* data = nullptr;
+        uint32_t size = 0;
+        uint32_t tries = 0;
+        bool pending = true;
+        bool hedged = false;
+        bool done = false;
+        uint16_t result = 0;
+        Clock::time_point started;
+        Clock::time_point retryAt;
+    };
+
+    CoordinatorParams params;
+    Logger* logger;
+    std::vector<Backend> backends;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread healthThread;
+    bool stopping;
+
+    bool querySum(Attempt& attempt, const uint16_t* data, uint32_t size, uint16_t& result);
+    void launch(std::vector<std::unique_ptr<Attempt>>& attempts, std::vector<Shard>& shards, size_t shard, size_t backend);
+    int pickBackend(const std::vector<std::unique_ptr<Attempt>>& attempts, size_t shard, bool allowRepeat,
+                    bool& exhausted, bool& repeat);
+    void cancelShard(std::vector<std::unique_ptr<Attempt>>& attempts, size_t shard);
+    void setHealthy(size_t backend, bool healthy);
+    void healthLoop();
+
+public:
+    ShardCoordinator();
+    ~ShardCoordinator();
+    bool configure(const CoordinatorParams& params, Logger* logger);
+    bool enabled() const;
+    uint32_t shardSize() const;
+    size_t checkHealth();
+    bool distribute(const std::vector<uint16_t>& vector, std::vector<uint16_t>& partials);
+};
+
+#endif
@@ -0,0 +1,618 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cache.h"
+#include "client_util.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadParams {
+    std::string host = "127.0.0.1";
+    uint16_t port = 33333;
+    std::string login = "user";
+    std::string password = "P@ssW0rd";
+    std::string authFormat = "mix";
+    std::string sizeSpec = "fixed:1000";
+    uint32_t connections = 100;
+    uint64_t sessions = 10000;
+    double duration = 0;
+    double rate = 0;
+    uint32_t reuse = 1;
+    bool hashOffer = false;
+    double minRps = 0;
+    double minMbps = 0;
+    uint32_t seed = 1;
+};
+
+// Распределение размеров векторов: fixed:N, uniform:A:B или exp:MEAN
+struct SizeDistribution {
+    std::string kind;
+    double a = 0;
+    double b = 0;
+
+    bool parse(const std::string& spec);
+    uint32_t sample(std::mt19937_64& rng) const;
+};
+
+// Заранее подготовленная сессия: готовый к отправке буфер и ожидаемые суммы.
+// Для --hash у каждого вектора отдельно предложение (размер с флагом + хеш) и данные.
+struct Workload {
+    std::string payload;
+    std::vector<uint16_t> expected;
+    std::vector<std::string> offers;
+    std::vector<std::string> bodies;
+};
+
+enum class ConnState { Idle, Connecting, SendAuth, RecvAuth, SendPayload, SendOffer, RecvVerdict, SendBody, RecvResults };
+
+struct Connection {
+    int fd = -1;
+    ConnState state = ConnState::Idle;
+    const std::string* auth = nullptr;
+    const Workload* work = nullptr;
+    size_t offset = 0;
+    size_t vectorIndex = 0;
+    uint64_t sent = 0;
+    std::string inbuf;
+    size_t expectBytes = 0;
+    Clock::time_point scheduled;
+};
+
+struct LoadStats {
+    uint64_t sessionsOk = 0;
+    uint64_t sessionsFailed = 0;
+    uint64_t authFailed = 0;
+    uint64_t mismatches = 0;
+    uint64_t requests = 0;
+    uint64_t bytes = 0;
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    std::vector<double> latenciesUs;
+};
+
+static const uint32_t MAX_VECTORS = 1000;
+// Совпадает с пределом сервера в режиме координатора
+static const uint32_t MAX_VECTOR_SIZE = 100000000;
+static const size_t WORKLOAD_POOL = 64;
+static const size_t WORKLOAD_POOL_BYTES = 256u << 20;
+static const size_t AUTH_POOL = 16;
+
+bool SizeDistribution::parse(const std::string& spec) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t pos = spec.find(':', start);
+        parts.push_back(spec.substr(start, pos - start));
+        if (pos == std::string::npos) break;
+        start = pos + 1;
+    }
+
+    try {
+        kind = parts[0];
+        if (kind == "fixed" && parts.size() == 2) {
+            a = b = std::stod(parts[1]);
+        } else if (kind == "uniform" && parts.size() == 3) {
+            a = std::stod(parts[1]);
+            b = std::stod(parts[2]);
+        } else if (kind == "exp" && parts.size() == 2) {
+            a = std::stod(parts[1]);
+        } else {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        return false;
+    }
+    return a >= 1 && a <= MAX_VECTOR_SIZE && (kind != "uniform" || (b >= a && b <= MAX_VECTOR_SIZE));
+}
+
+uint32_t SizeDistribution::sample(std::mt19937_64& rng) const {
+    double value = a;
+    if (kind == "uniform") {
+        value = std::uniform_int_distribution<uint32_t>(a, b)(rng);
+    } else if (kind == "exp") {
+        value = std::exponential_distribution<double>(1.0 / a)(rng);
+    }
+    return static_cast<uint32_t>(std::max(1.0, std::min(value, static_cast<double>(MAX_VECTOR_SIZE))));
+}
+
+static bool parseCommandLine(int argc, char** argv, LoadParams& params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: loadgen [options]\n"
+                      << "Options:\n"
+                      << "  -h, --help\t\tShow this help message\n"
+                      << "  -H, --host <addr>\tServer address (default: 127.0.0.1)\n"
+                      << "  -p, --port <port>\tPort number (default: 33333)\n"
+                      << "  -u, --user <login>\tLogin (default: user)\n"
+                      << "  -w, --password <pw>\tPassword (default: P@ssW0rd)\n"
+                      << "  -a, --auth <fmt>\tAuth frame: 76, 80 or mix (default: mix)\n"
+                      << "  -c, --connections <n>\tConcurrent connections (default: 100)\n"
+                      << "  -n, --sessions <n>\tSessions to run (default: 10000)\n"
+                      << "  -d, --duration <sec>\tRun for a fixed time instead of -n\n"
+                      << "  -r, --rate <n>\t\tOpen loop: Poisson arrivals, sessions/s (default: 0 - closed loop)\n"
+                      << "  -v, --reuse <n>\tVectors sent per connection (default: 1)\n"
+                      << "  -x, --hash\t\tOffer vector hashes first, send data only on a cache miss\n"
+                      << "  -s, --sizes <spec>\tVector sizes: fixed:N, uniform:A:B, exp:MEAN (default: fixed:1000)\n"
+                      << "  --seed <n>\t\tRandom seed (default: 1)\n"
+                      << "  --min-rps <n>\t\tFail if requests/s is below the floor\n"
+                      << "  --min-mbps <n>\t\tFail if MB/s is below the floor\n";
+            return false;
+        }
+        else if ((arg == "-H" || arg == "--host") && i + 1 < argc) {
+            params.host = argv[++i];
+        }
+        else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            params.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        }
+        else if ((arg == "-u" || arg == "--user") && i + 1 < argc) {
+            params.login = argv[++i];
+        }
+        else if ((arg == "-w" || arg == "--password") && i + 1 < argc) {
+            params.password = argv[++i];
+        }
+        else if ((arg == "-a" || arg == "--auth") && i + 1 < argc) {
+            params.authFormat = argv[++i];
+        }
+        else if ((arg == "-c" || arg == "--connections") && i + 1 < argc) {
+            params.connections = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if ((arg == "-n" || arg == "--sessions") && i + 1 < argc) {
+            params.sessions = std::stoull(argv[++i]);
+        }
+        else if ((arg == "-d" || arg == "--duration") && i + 1 < argc) {
+            params.duration = std::stod(argv[++i]);
+        }
+        else if ((arg == "-r" || arg == "--rate") && i + 1 < argc) {
+            params.rate = std::stod(argv[++i]);
+        }
+        else if ((arg == "-v" || arg == "--reuse") && i + 1 < argc) {
+            params.reuse = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "-x" || arg == "--hash") {
+            params.hashOffer = true;
+        }
+        else if ((arg == "-s" || arg == "--sizes") && i + 1 < argc) {
+            params.sizeSpec = argv[++i];
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            params.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--min-rps" && i + 1 < argc) {
+            params.minRps = std::stod(argv[++i]);
+        }
+        else if (arg == "--min-mbps" && i + 1 < argc) {
+            params.minMbps = std::stod(argv[++i]);
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (params.connections == 0 || params.reuse == 0 || params.reuse > MAX_VECTORS) {
+        std::cerr << "Connections must be positive, reuse must be in 1.." << MAX_VECTORS << std::endl;
+        return false;
+    }
+    if (params.authFormat != "76" && params.authFormat != "80" && params.authFormat != "mix") {
+        std::cerr << "Auth format must be 76, 80 or mix" << std::endl;
+        return false;
+    }
+    if (params.authFormat != "80" && params.login != "user") {
+        std::cerr << "76-byte auth frame supports only login 'user'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static Workload buildWorkload(const LoadParams& params, const SizeDistribution& sizes, std::mt19937_64& rng) {
+    Workload work;
+    uint32_t numVectors = params.reuse;
+    work.payload.append(reinterpret_cast<const char*>(&numVectors), sizeof(numVectors));
+
+    for (uint32_t i = 0; i < numVectors; i++) {
+        uint32_t vectorSize = sizes.sample(rng);
+        std::vector<uint16_t> vector(vectorSize);
+        uint32_t sum = 0;
+        for (uint16_t& value : vector) {
+            value = static_cast<uint16_t>(rng() % 64);
+            sum = std::min<uint32_t>(sum + value, UINT16_MAX);
+        }
+        work.expected.push_back(static_cast<uint16_t>(sum));
+
+        std::string body(reinterpret_cast<const char*>(vector.data()), vectorSize * sizeof(uint16_t));
+        work.payload.append(reinterpret_cast<const char*>(&vectorSize), sizeof(vectorSize));
+        work.payload.append(body);
+
+        uint32_t offeredSize = vectorSize | HASH_OFFER_FLAG;
+        uint64_t hash = xxHash64(body.data(), body.size());
+        std::string offer = i == 0 ? work.payload.substr(0, sizeof(numVectors)) : std::string();
+        offer.append(reinterpret_cast<const char*>(&offeredSize), sizeof(offeredSize));
+        offer.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        work.offers.push_back(offer);
+        work.bodies.push_back(body);
+    }
+    return work;
+}
+
+class LoadGenerator {
+private:
+    LoadParams params;
+    sockaddr_in serverAddr;
+    int epollFd;
+    std::mt19937_64 rng;
+    std::vector<std::string> authFrames;
+    std::vector<Workload> workloads;
+    std::vector<Connection> conns;
+    std::vector<size_t> idle;
+    std::deque<Clock::time_point> arrivals;
+    LoadStats stats;
+
+    void startSession(size_t slot, Clock::time_point scheduled);
+    void finishSession(size_t slot, bool ok);
+    void watch(Connection& conn, uint32_t events);
+    bool sendPending(Connection& conn, const std::string& data);
+    void advance(size_t slot);
+    bool checkResults(const Connection& conn);
+
+public:
+    LoadGenerator(const LoadParams& params);
+    bool prepare();
+    int run();
+    void report(double elapsedSec);
+};
+
+LoadGenerator::LoadGenerator(const LoadParams& p) : params(p), epollFd(-1), rng(p.seed) {}
+
+bool LoadGenerator::prepare() {
+    std::memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(params.port);
+    if (inet_pton(AF_INET, params.host.c_str(), &serverAddr.sin_addr) != 1) {
+        std::cerr << "Invalid server address: " << params.host << std::endl;
+        return false;
+    }
+
+    SizeDistribution sizes;
+    if (!sizes.parse(params.sizeSpec)) {
+        std::cerr << "Invalid size distribution: " << params.sizeSpec << std::endl;
+        return false;
+    }
+
+    // Тысячи соединений не помещаются в стандартный лимит дескрипторов
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < params.connections + 64) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, params.connections + 64);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (size_t i = 0; i < AUTH_POOL; i++) {
+        bool wide = params.authFormat == "80" || (params.authFormat == "mix" && i % 2 == 1);
+        authFrames.push_back(buildAuthFrame(params.login, params.password, rng, wide));
+    }
+    // Для крупных векторов пул короче: рабочие нагрузки не растут сверх бюджета памяти
+    size_t poolBytes = 0;
+    for (size_t i = 0; i < WORKLOAD_POOL && poolBytes < WORKLOAD_POOL_BYTES; i++) {
+        workloads.push_back(buildWorkload(params, sizes, rng));
+        poolBytes += workloads.back().payload.size();
+    }
+
+    conns.resize(params.connections);
+    for (size_t i = params.connections; i > 0; i--) idle.push_back(i - 1);
+
+    epollFd = epoll_create1(0);
+    return epollFd >= 0;
+}
+
+void LoadGenerator::watch(Connection& conn, uint32_t events) {
+    epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = &conn - conns.data();
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void LoadGenerator::startSession(size_t slot, Clock::time_point scheduled) {
+    Connection& conn = conns[slot];
+    conn = Connection();
+    conn.scheduled = scheduled;
+    conn.auth = &authFrames[rng() % authFrames.size()];
+    conn.work = &workloads[rng() % workloads.size()];
+
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (conn.fd < 0) {
+        finishSession(slot, false);
+        return;
+    }
+    int opt = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    if (connect(conn.fd, (sockaddr*)&serverAddr, sizeof(serverAddr)) < 0 && errno != EINPROGRESS) {
+        finishSession(slot, false);
+        return;
+    }
+
+    conn.state = ConnState::Connecting;
+    epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.u64 = slot;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, conn.fd, &ev);
+}
+
+void LoadGenerator::finishSession(size_t slot, bool ok) {
+    Connection& conn = conns[slot];
+    if (conn.fd >= 0) close(conn.fd);
+
+    if (ok) {
+        stats.sessionsOk++;
+        stats.requests += conn.work->expected.size();
+        stats.bytes += conn.sent;
+        stats.latenciesUs.push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - conn.scheduled).count());
+    } else {
+        stats.sessionsFailed++;
+    }
+
+    conn = Connection();
+    idle.push_back(slot);
+}
+
+bool LoadGenerator::sendPending(Connection& conn, const std::string& data) {
+    while (conn.offset < data.size()) {
+        ssize_t sent = send(conn.fd, data.data() + conn.offset, data.size() - conn.offset, MSG_NOSIGNAL);
+        if (sent < 0) return false;
+        conn.offset += sent;
+        conn.sent += sent;
+    }
+    return true;
+}
+
+bool LoadGenerator::checkResults(const Connection& conn) {
+    uint32_t numResults;
+    std::memcpy(&numResults, conn.inbuf.data(), sizeof(numResults));
+    if (numResults != conn.work->expected.size()) return false;
+    return std::memcmp(conn.inbuf.data() + sizeof(numResults), conn.work->expected.data(),
+                       numResults * sizeof(uint16_t)) == 0;
+}
+
+// Продвигает конечный автомат соединения, пока сокет не вернёт EAGAIN
+void LoadGenerator::advance(size_t slot) {
+    Connection& conn = conns[slot];
+    char buffer[4096];
+
+    while (true) {
+        switch (conn.state) {
+        case ConnState::Connecting: {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                finishSession(slot, false);
+                return;
+            }
+            conn.state = ConnState::SendAuth;
+            break;
+        }
+        case ConnState::SendAuth:
+            if (!sendPending(conn, *conn.auth)) {
+                if (errno == EAGAIN) return;
+                finishSession(slot, false);
+                return;
+            }
+            conn.state = ConnState::RecvAuth;
+            watch(conn, EPOLLIN);
+            break;
+        case ConnState::RecvAuth: {
+            ssize_t got = recv(conn.fd, buffer, 2 - conn.inbuf.size(), 0);
+            if (got < 0 && errno == EAGAIN) return;
+            if (got <= 0) {
+                finishSession(slot, false);
+                return;
+            }
+            conn.inbuf.append(buffer, got);
+            if (conn.inbuf.size() < 2) break;
+            if (conn.inbuf != "OK") {
+                stats.authFailed++;
+                finishSession(slot, false);
+                return;
+            }
+            conn.inbuf.clear();
+            conn.offset = 0;
+            conn.state = params.hashOffer ? ConnState::SendOffer : ConnState::SendPayload;
+            watch(conn, EPOLLOUT);
+            break;
+        }
+        case ConnState::SendOffer:
+            if (!sendPending(conn, conn.work->offers[conn.vectorIndex])) {
+                if (errno == EAGAIN) return;
+                finishSession(slot, false);
+                return;
+            }
+            conn.state = ConnState::RecvVerdict;
+            watch(conn, EPOLLIN);
+            break;
+        case ConnState::RecvVerdict: {
+            char verdict;
+            ssize_t got = recv(conn.fd, &verdict, sizeof(verdict), 0);
+            if (got < 0 && errno == EAGAIN) return;
+            if (got <= 0 || (verdict != CACHE_HIT && verdict != CACHE_MISS)) {
+                finishSession(slot, false);
+                return;
+            }
+            conn.offset = 0;
+            if (verdict == CACHE_MISS) {
+                stats.cacheMisses++;
+                conn.state = ConnState::SendBody;
+                watch(conn, EPOLLOUT);
+                break;
+            }
+            stats.cacheHits++;
+            if (++conn.vectorIndex < conn.work->offers.size()) {
+                conn.state = ConnState::SendOffer;
+                watch(conn, EPOLLOUT);
+                break;
+            }
+            conn.expectBytes = sizeof(uint32_t) + conn.work->expected.size() * sizeof(uint16_t);
+            conn.state = ConnState::RecvResults;
+            break;
+        }
+        case ConnState::SendBody:
+            if (!sendPending(conn, conn.work->bodies[conn.vectorIndex])) {
+                if (errno == EAGAIN) return;
+                finishSession(slot, false);
+                return;
+            }
+            conn.offset = 0;
+            if (++conn.vectorIndex < conn.work->offers.size()) {
+                conn.state = ConnState::SendOffer;
+                break;
+            }
+            conn.expectBytes = sizeof(uint32_t) + conn.work->expected.size() * sizeof(uint16_t);
+            conn.state = ConnState::RecvResults;
+            watch(conn, EPOLLIN);
+            break;
+        case ConnState::SendPayload:
+            if (!sendPending(conn, conn.work->payload)) {
+                if (errno == EAGAIN) return;
+                finishSession(slot, false);
+                return;
+            }
+            conn.expectBytes = sizeof(uint32_t) + conn.work->expected.size() * sizeof(uint16_t);
+            conn.state = ConnState::RecvResults;
+            watch(conn, EPOLLIN);
+            break;
+        case ConnState::RecvResults: {
+            size_t want = std::min(sizeof(buffer), conn.expectBytes - conn.inbuf.size());
+            ssize_t got = recv(conn.fd, buffer, want, 0);
+            if (got < 0 && errno == EAGAIN) return;
+            if (got <= 0) {
+                finishSession(slot, false);
+                return;
+            }
+            conn.inbuf.append(buffer, got);
+            if (conn.inbuf.size() < conn.expectBytes) break;
+            bool ok = checkResults(conn);
+            if (!ok) stats.mismatches++;
+            finishSession(slot, ok);
+            return;
+        }
+        case ConnState::Idle:
+            return;
+        }
+    }
+}
+
+int LoadGenerator::run() {
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::microseconds(static_cast<uint64_t>(params.duration * 1e6));
+    Clock::time_point nextArrival = start;
+    std::exponential_distribution<double> gap(params.rate > 0 ? params.rate : 1.0);
+    uint64_t issued = 0;
+    std::vector<epoll_event> events(1024);
+
+    while (true) {
+        Clock::time_point now = Clock::now();
+        bool accepting = params.duration > 0 ? now < deadline : issued < params.sessions;
+
+        // Открытый цикл: заявки приходят по расписанию независимо от ответов сервера,
+        // поэтому задержка считается от запланированного момента, а не от connect()
+        if (params.rate > 0) {
+            while (accepting && nextArrival <= now) {
+                arrivals.push_back(nextArrival);
+                nextArrival += std::chrono::microseconds(static_cast<uint64_t>(gap(rng) * 1e6));
+                issued++;
+                accepting = params.duration > 0 ? nextArrival < deadline : issued < params.sessions;
+            }
+        } else {
+            while (accepting && arrivals.size() < idle.size()) {
+                arrivals.push_back(now);
+                issued++;
+                accepting = params.duration > 0 || issued < params.sessions;
+            }
+        }
+
+        while (!idle.empty() && !arrivals.empty()) {
+            size_t slot = idle.back();
+            idle.pop_back();
+            Clock::time_point scheduled = arrivals.front();
+            arrivals.pop_front();
+            startSession(slot, scheduled);
+        }
+
+        if (!accepting && arrivals.empty() && idle.size() == conns.size()) break;
+
+        int timeoutMs = 100;
+        if (params.rate > 0 && accepting) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextArrival - Clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait, timeoutMs)));
+        }
+
+        int ready = epoll_wait(epollFd, events.data(), events.size(), timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        for (int i = 0; i < ready; i++) {
+            advance(events[i].data.u64);
+        }
+    }
+
+    double elapsedSec = std::chrono::duration<double>(Clock::now() - start).count();
+    report(elapsedSec);
+
+    double rps = stats.requests / elapsedSec;
+    double mbps = stats.bytes / elapsedSec / (1024.0 * 1024.0);
+    if (rps < params.minRps || mbps < params.minMbps) {
+        std::cerr << "Throughput below floor (min " << params.minRps << " req/s, "
+                  << params.minMbps << " MB/s)" << std::endl;
+        return 2;
+    }
+    return stats.sessionsFailed == 0 ? 0 : 2;
+}
+
+void LoadGenerator::report(double elapsedSec) {
+    std::sort(stats.latenciesUs.begin(), stats.latenciesUs.end());
+    uint64_t sessions = stats.sessionsOk + stats.sessionsFailed;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Sessions:    " << sessions << " (ok: " << stats.sessionsOk
+              << ", failed: " << stats.sessionsFailed << ", auth failed: " << stats.authFailed
+              << ", wrong sums: " << stats.mismatches << ")\n";
+    std::cout << "Elapsed:     " << elapsedSec << " s\n";
+    std::cout << "Throughput:  " << stats.requests / elapsedSec << " requests/s, "
+              << stats.sessionsOk / elapsedSec << " sessions/s, "
+              << stats.bytes / elapsedSec / (1024.0 * 1024.0) << " MB/s sent\n";
+    if (params.hashOffer) {
+        uint64_t offers = stats.cacheHits + stats.cacheMisses;
+        std::cout << "Cache:       " << stats.cacheHits << " hits, " << stats.cacheMisses << " misses, hit rate "
+                  << (offers == 0 ? 0.0 : 100.0 * stats.cacheHits / offers) << "%\n";
+    }
+    std::cout << "Latency ms:  p50 " << percentile(stats.latenciesUs, 0.50) / 1000
+              << ", p99 " << percentile(stats.latenciesUs, 0.99) / 1000
+              << ", p999 " << percentile(stats.latenciesUs, 0.999) / 1000
+              << ", max " << (stats.latenciesUs.empty() ? 0.0 : stats.latenciesUs.back() / 1000) << "\n";
+}
+
+int main(int argc, char** argv) {
+    LoadParams params;
+    if (!parseCommandLine(argc, argv, params)) return 1;
+
+    LoadGenerator generator(params);
+    if (!generator.prepare()) return 1;
+    return generator.run();
+}
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Сквозной тест производительности: поднимает сервер на loopback и гоняет loadgen
+# с порогами пропускной способности. Аргументы: <server> <loadgen> <replay> <auth-файл> [порт]
+SERVER="$1"
+LOADGEN="$2"
+REPLAY="$3"
+AUTH="$4"
+PORT="${5:-34567}"
+WORKDIR=$(mktemp -d)
+PIDS=""
+
+trap 'kill $PIDS 2>/dev/null; rm -rf "$WORKDIR"' EXIT
+
+start_server() {
+    NAME="$1"
+    shift
+    "$SERVER" -a "$AUTH" -l "$WORKDIR/$NAME.log" "$@" > /dev/null 2>&1 &
+    LAST_PID=$!
+    PIDS="$PIDS $!"
+    sleep 1
+    if ! kill -0 $! 2>/dev/null; then
+        echo "Server $NAME failed to start"
+        exit 1
+    fi
+}
+
+start_server single -p "$PORT" -c 1000
+
+# Много одновременных соединений, замкнутый цикл
+"$LOADGEN" -p "$PORT" -c 1000 -n 2000 -s uniform:1:10000 --min-rps 200 || exit 1
+
+# Открытый цикл с повторным использованием соединения под несколько векторов
+"$LOADGEN" -p "$PORT" -c 64 -d 2 -r 100 -v 20 -s exp:5000 --min-rps 500 --min-mbps 1 || exit 1
+
+# Повторяющиеся векторы по хешу: сумма из кэша без передачи данных
+"$LOADGEN" -p "$PORT" -c 64 -n 2000 -v 5 -s uniform:1000:20000 --hash --min-rps 2000 || exit 1
+
+# Координатор раздаёт большие векторы двум локальным бэкендам
+start_server backend1 -p $((PORT + 1))
+start_server backend2 -p $((PORT + 2))
+start_server coordinator -p $((PORT + 3)) -b "127.0.0.1:$((PORT + 1)),127.0.0.1:$((PORT + 2))" --shard-size 100000
+
+# Векторы крупнее локального предела в 1000000 элементов принимает только координатор
+"$LOADGEN" -p $((PORT + 3)) -c 4 -n 16 -s uniform:1500000:4000000 --min-mbps 5 || exit 1
+
+if ! grep -q "summed across" "$WORKDIR/coordinator.log"; then
+    echo "Coordinator did not shard any vector"
+    exit 1
+fi
+
+# Запись трассы сервером и её воспроизведение на чистом сервере без кэша:
+# в трассе есть обычные векторы, промахи и попадания по хешу
+start_server capture -p $((PORT + 4)) -c 1000 -t "$WORKDIR/capture.bin"
+CAPTURE_PID=$LAST_PID
+"$LOADGEN" -p $((PORT + 4)) -c 16 -n 200 -v 3 -s uniform:1:5000 || exit 1
+"$LOADGEN" -p $((PORT + 4)) -c 16 -n 300 -v 3 -s uniform:1:5000 --hash || exit 1
+kill $CAPTURE_PID
+
+start_server target -p $((PORT + 5))
+if ! "$REPLAY" -f "$WORKDIR/capture.bin" -p $((PORT + 5)) -x 0; then
+    echo "Replay of the captured trace failed"
+    exit 1
+fi
@@ -0,0 +1,344 @@
+#include "trace.h"
+#include "cache.h"
+#include "client_util.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ReplayParams {
+    std::string traceFile;
+    std::string host = "127.0.0.1";
+    uint16_t port = 33333;
+    double speed = 1.0;
+    uint32_t concurrency = 256;
+};
+
+struct ReplayStats {
+    uint64_t sessionsOk = 0;
+    uint64_t sessionsFailed = 0;
+    uint64_t authOnly = 0;
+    uint64_t notReplayable = 0;
+    uint64_t vectorsSent = 0;
+    uint64_t cacheHits = 0;
+    uint64_t bytesSent = 0;
+    std::vector<double> latenciesMs;
+};
+
+// Вектор сессии, готовый к отправке. Данные общие: вектор, предложенный по хешу,
+// может понадобиться и более поздним сессиям, у которых в трассе только хеш
+struct ReplayVector {
+    uint32_t size = 0;
+    TraceVector::Kind kind = TraceVector::PLAIN;
+    uint64_t hash = 0;
+    std::shared_ptr<const std::vector<uint16_t>> data;
+};
+
+struct ReplayJob {
+    std::string authFrame;
+    bool authorized = false;
+    Clock::time_point due;
+    std::vector<ReplayVector> vectors;
+};
+
+// Сессия, где цель просит данные вектора, записанного как попадание в кэш, а данных
+// нет ни в ней, ни в более ранних сессиях трассы (с выборкой -s они могли уйти в
+// незаписанной сессии), не воспроизводима. Это свойство трассы, а не ошибка цели
+enum SessionResult { SESSION_OK, SESSION_FAILED, SESSION_NOT_REPLAYABLE };
+
+// Данные векторов, которые уже предлагались по хешу: при записи сервер мог ответить
+// из кэша, а при воспроизведении - попросить данные
+typedef std::map<std::pair<uint64_t, uint32_t>, std::shared_ptr<const std::vector<uint16_t>>> KnownVectors;
+
+// Сессии выполняются параллельно, каждая в своём потоке; общая статистика - под mutex
+struct ReplayState {
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t active = 0;
+    ReplayStats stats;
+};
+
+static bool parseCommandLine(int argc, char** argv, ReplayParams& params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: replay -f <trace> [options]\n"
+                      << "Options:\n"
+                      << "  -h, --help\t\tShow this help message\n"
+                      << "  -f, --file <file>\tTrace file recorded by server --trace\n"
+                      << "  -H, --host <addr>\tServer address (default: 127.0.0.1)\n"
+                      << "  -p, --port <port>\tPort number (default: 33333)\n"
+                      << "  -x, --speed <n>\tReplay speed: 1 - real time, N - N times faster,\n"
+                      << "\t\t\t0 - as fast as possible (default: 1)\n"
+                      << "  -c, --concurrency <n>\tMax sessions in flight (default: 256)\n"
+                      << "Sessions start at the recorded offsets, which are the times the traced\n"
+                      << "server began serving them, not client arrival times. Latency is measured\n"
+                      << "from the scheduled start, so time spent waiting behind a slow target counts.\n";
+            return false;
+        }
+        else if ((arg == "-f" || arg == "--file") && i + 1 < argc) {
+            params.traceFile = argv[++i];
+        }
+        else if ((arg == "-H" || arg == "--host") && i + 1 < argc) {
+            params.host = argv[++i];
+        }
+        else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            params.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        }
+        else if ((arg == "-x" || arg == "--speed") && i + 1 < argc) {
+            params.speed = std::stod(argv[++i]);
+        }
+        else if ((arg == "-c" || arg == "--concurrency") && i + 1 < argc) {
+            params.concurrency = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (params.traceFile.empty()) {
+        std::cerr << "Trace file is required (-f)" << std::endl;
+        return false;
+    }
+    if (params.speed < 0) {
+        std::cerr << "Speed must not be negative" << std::endl;
+        return false;
+    }
+    if (params.concurrency == 0) {
+        std::cerr << "Concurrency must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static int connectTo(const ReplayParams& params) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+
+    // Заголовки и ответы - короткие пакеты: без TCP_NODELAY Nagle вместе с
+    // отложенным ACK добавляет к каждой сессии ~40 мс и искажает задержки
+    int opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(params.port);
+    if (inet_pton(AF_INET, params.host.c_str(), &addr.sin_addr) != 1 ||
+        connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Переводит сессию из трассы в задание: данные переходят в общие буферы,
+// а векторам, от которых в трассе остался только хеш, достаются данные
+// более раннего предложения того же хеша, если оно было
+static ReplayJob buildJob(TraceSession& session, KnownVectors& known) {
+    ReplayJob job;
+    job.authFrame = session.authFrame;
+    job.authorized = session.authorized;
+
+    for (TraceVector& traced : session.vectors) {
+        ReplayVector vector;
+        vector.size = traced.size;
+        vector.kind = traced.kind;
+        vector.hash = traced.hash;
+
+        std::pair<uint64_t, uint32_t> key(traced.hash, traced.size);
+        if (traced.kind == TraceVector::OFFER_HIT) {
+            KnownVectors::const_iterator it = known.find(key);
+            if (it != known.end()) vector.data = it->second;
+        } else {
+            vector.data = std::make_shared<const std::vector<uint16_t>>(std::move(traced.data));
+            if (traced.kind == TraceVector::OFFER_MISS) known[key] = vector.data;
+        }
+        job.vectors.push_back(vector);
+    }
+    return job;
+}
+
+// Воспроизводит одну сессию; SESSION_OK, если сервер ответил так же, как при записи:
+// тот же результат аутентификации и по одной сумме на каждый отправленный вектор
+static SessionResult replaySession(const ReplayParams& params, const ReplayJob& job, ReplayStats& stats) {
+    int sock = connectTo(params);
+    if (sock < 0) return SESSION_FAILED;
+
+    if (!sendAll(sock, job.authFrame.data(), job.authFrame.size())) {
+        close(sock);
+        return SESSION_FAILED;
+    }
+
+    char reply[4] = {0};
+    ssize_t replyLen = recv(sock, reply, sizeof(reply) - 1, 0);
+    bool authorized = replyLen == 2 && std::strncmp(reply, "OK", 2) == 0;
+
+    if (authorized != job.authorized || !authorized || job.vectors.empty()) {
+        close(sock);
+        return authorized == job.authorized ? SESSION_OK : SESSION_FAILED;
+    }
+
+    // Запрос копится в буфере и уходит целиком; отправка раньше - только
+    // перед ожиданием ответа сервера на предложенный хеш
+    uint32_t numVectors = job.vectors.size();
+    std::string request(reinterpret_cast<const char*>(&numVectors), sizeof(numVectors));
+    bool ok = true;
+    for (const ReplayVector& vector : job.vectors) {
+        if (vector.kind == TraceVector::PLAIN) {
+            request.append(reinterpret_cast<const char*>(&vector.size), sizeof(vector.size));
+        } else {
+            uint32_t offeredSize = vector.size | HASH_OFFER_FLAG;
+            request.append(reinterpret_cast<const char*>(&offeredSize), sizeof(offeredSize));
+            request.append(reinterpret_cast<const char*>(&vector.hash), sizeof(vector.hash));
+
+            char verdict = 0;
+            ok = sendAll(sock, request.data(), request.size()) && recvAll(sock, &verdict, sizeof(verdict));
+            request.clear();
+            if (ok && verdict == CACHE_HIT) {
+                stats.cacheHits++;
+                continue;
+            }
+            ok = ok && verdict == CACHE_MISS;
+            if (!ok) break;
+            if (!vector.data) {
+                close(sock);
+                return SESSION_NOT_REPLAYABLE;
+            }
+        }
+
+        request.append(reinterpret_cast<const char*>(vector.data->data()), vector.size * sizeof(uint16_t));
+        stats.bytesSent += vector.size * sizeof(uint16_t);
+    }
+
+    ok = ok && sendAll(sock, request.data(), request.size());
+    if (ok) stats.vectorsSent += numVectors;
+
+    uint32_t numResults = 0;
+    ok = ok && recvAll(sock, &numResults, sizeof(numResults)) && numResults == numVectors;
+    if (ok) {
+        std::vector<uint16_t> results(numResults);
+        ok = recvAll(sock, results.data(), numResults * sizeof(uint16_t));
+    }
+
+    close(sock);
+    return ok ? SESSION_OK : SESSION_FAILED;
+}
+
+// Поток одной сессии. Задержка считается от запланированного начала, а не от
+// фактического: если цель не успевает и сессии ждут, ожидание входит в задержку
+static void runJob(const ReplayParams& params, ReplayJob job, ReplayState& state) {
+    ReplayStats local;
+    SessionResult result = replaySession(params, job, local);
+    double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - job.due).count();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    ReplayStats& stats = state.stats;
+    stats.vectorsSent += local.vectorsSent;
+    stats.cacheHits += local.cacheHits;
+    stats.bytesSent += local.bytesSent;
+
+    // Сессии без векторов (в том числе с отказом в аутентификации) проверяются,
+    // но в распределение задержек не попадают
+    if (result == SESSION_OK) {
+        stats.sessionsOk++;
+        if (job.vectors.empty()) {
+            stats.authOnly++;
+        } else {
+            stats.latenciesMs.push_back(latencyMs);
+        }
+    } else if (result == SESSION_NOT_REPLAYABLE) {
+        stats.notReplayable++;
+    } else {
+        stats.sessionsFailed++;
+    }
+
+    // Уведомление под mutex: после его освобождения поток не трогает state
+    state.active--;
+    state.changed.notify_all();
+}
+
+static void printReport(ReplayStats& stats, double elapsedSec) {
+    std::sort(stats.latenciesMs.begin(), stats.latenciesMs.end());
+    uint64_t sessions = stats.sessionsOk + stats.sessionsFailed + stats.notReplayable;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Sessions:    " << sessions << " (ok: " << stats.sessionsOk
+              << ", failed: " << stats.sessionsFailed << ", auth only: " << stats.authOnly
+              << ", not replayable: " << stats.notReplayable << ")\n";
+    std::cout << "Vectors:     " << stats.vectorsSent << " (cache hits: " << stats.cacheHits << ")\n";
+    std::cout << "Elapsed:     " << elapsedSec << " s\n";
+    if (elapsedSec > 0) {
+        std::cout << "Throughput:  " << sessions / elapsedSec << " sessions/s, "
+                  << stats.vectorsSent / elapsedSec << " vectors/s, "
+                  << stats.bytesSent / elapsedSec / (1024.0 * 1024.0) << " MB/s\n";
+    }
+    std::cout << "Latency ms:  (sessions with vectors only) p50 " << percentile(stats.latenciesMs, 0.50)
+              << ", p90 " << percentile(stats.latenciesMs, 0.90)
+              << ", p99 " << percentile(stats.latenciesMs, 0.99)
+              << ", max " << (stats.latenciesMs.empty() ? 0.0 : stats.latenciesMs.back()) << "\n";
+}
+
+int main(int argc, char** argv) {
+    ReplayParams params;
+    if (!parseCommandLine(argc, argv, params)) return 1;
+
+    TraceReader reader;
+    if (!reader.open(params.traceFile)) {
+        std::cerr << "Cannot open trace file: " << params.traceFile << std::endl;
+        return 1;
+    }
+
+    ReplayState state;
+    KnownVectors known;
+    TraceSession session;
+    Clock::time_point replayStart = Clock::now();
+    bool first = true;
+    uint64_t firstOffsetUs = 0;
+
+    while (reader.next(session)) {
+        if (first) {
+            firstOffsetUs = session.offsetUs;
+            first = false;
+        }
+
+        ReplayJob job = buildJob(session, known);
+
+        // Сохраняем исходные интервалы между сессиями с учётом ускорения
+        job.due = Clock::now();
+        if (params.speed > 0) {
+            job.due = replayStart + std::chrono::microseconds(
+                static_cast<uint64_t>((session.offsetUs - firstOffsetUs) / params.speed));
+            std::this_thread::sleep_until(job.due);
+        }
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.changed.wait(lock, [&]() { return state.active < params.concurrency; });
+        state.active++;
+        lock.unlock();
+
+        std::thread(runJob, std::cref(params), std::move(job), std::ref(state)).detach();
+    }
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.changed.wait(lock, [&]() { return state.active == 0; });
+
+    double elapsedSec = std::chrono::duration<double>(Clock::now() - replayStart).count();
+    printReport(state.stats, elapsedSec);
+    // Невоспроизводимые сессии - свойство трассы, на код возврата они не влияют
+    return state.stats.sessionsFailed == 0 ? 0 : 2;
+}
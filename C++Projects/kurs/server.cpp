@@ -15,6 +15,10 @@
 
 namespace CPP = CryptoPP;
 
+static const uint32_t LOCAL_MAX_VECTOR_SIZE = 1000000;
+static const uint32_t COORDINATOR_MAX_VECTOR_SIZE = 100000000;
+static const uint32_t HARD_MAX_VECTOR_SIZE = 500000000;
+
 bool parseCommandLine(int argc, char** argv, ServerParams& params) {
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -25,7 +29,21 @@ bool parseCommandLine(int argc, char** argv, ServerParams& params) {
                       << "  -h, --help\t\tShow this help message\n"
                       << "  -a, --auth <file>\tAuthentication file (default: ./vcalc.conf)\n"
                       << "  -l, --log <file>\tLog file (default: ./log/vcalc.log)\n"
-                      << "  -p, --port <port>\tPort number (default: 33333)\n";
+                      << "  -p, --port <port>\tPort number (default: 33333)\n"
+                      << "  -t, --trace <file>\tRecord client sessions to a binary trace file\n"
+                      << "  -s, --sample <n>\tRecord every n-th session to the trace (default: 1)\n"
+                      << "  -c, --cache <n>\tCache sums of up to n vectors offered by hash (default: 0 - off)\n"
+                      << "  -m, --max-size <n>\tMax vector size (default: 1000000, coordinator: 100000000)\n"
+                      << "Coordinator mode:\n"
+                      << "  -b, --backends <list>\tComma-separated host:port backends to shard vectors across\n"
+                      << "  --backend-auth <l:p>\tCredentials for backends (default: user:P@ssW0rd)\n"
+                      << "  --shard-size <n>\tMax elements per shard (default: 1000000)\n"
+                      << "  --retries <n>\t\tRetries of a failed shard, on other backends first (default: 2)\n"
+                      << "  --retry-backoff <ms>\tPause before retrying on an already tried backend,\n"
+                      << "\t\t\tgrows with each attempt (default: 50)\n"
+                      << "  --backend-inflight <n>\tMax shards sent to one backend at once (default: 1)\n"
+                      << "  --hedge <ms>\t\tDuplicate a shard that is slower than this, 0 - off (default: 50)\n"
+                      << "  --timeout <ms>\t\tBackend connect/IO timeout (default: 2000)\n";
             return false;
         }
         else if ((arg == "-a" || arg == "--auth") && i + 1 < argc) {
@@ -37,6 +55,57 @@ bool parseCommandLine(int argc, char** argv, ServerParams& params) {
         else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
             params.port = static_cast<uint16_t>(std::stoi(argv[++i]));
         }
+        else if ((arg == "-t" || arg == "--trace") && i + 1 < argc) {
+            params.traceFile = argv[++i];
+        }
+        else if ((arg == "-s" || arg == "--sample") && i + 1 < argc) {
+            params.traceSample = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if ((arg == "-c" || arg == "--cache") && i + 1 < argc) {
+            params.cacheEntries = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if ((arg == "-m" || arg == "--max-size") && i + 1 < argc) {
+            params.maxVectorSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+            if (params.maxVectorSize > HARD_MAX_VECTOR_SIZE) {
+                std::cerr << "Max vector size is limited to " << HARD_MAX_VECTOR_SIZE << std::endl;
+                return false;
+            }
+        }
+        else if ((arg == "-b" || arg == "--backends") && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string backend;
+            while (std::getline(list, backend, ',')) {
+                if (!backend.empty()) params.coordinator.backends.push_back(backend);
+            }
+        }
+        else if (arg == "--backend-auth" && i + 1 < argc) {
+            std::string credentials = argv[++i];
+            size_t pos = credentials.find(':');
+            if (pos == std::string::npos) {
+                std::cerr << "Backend credentials must be login:password" << std::endl;
+                return false;
+            }
+            params.coordinator.login = credentials.substr(0, pos);
+            params.coordinator.password = credentials.substr(pos + 1);
+        }
+        else if (arg == "--shard-size" && i + 1 < argc) {
+            params.coordinator.shardSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--retries" && i + 1 < argc) {
+            params.coordinator.retries = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--backend-inflight" && i + 1 < argc) {
+            params.coordinator.maxInflight = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--retry-backoff" && i + 1 < argc) {
+            params.coordinator.retryBackoffMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--hedge" && i + 1 < argc) {
+            params.coordinator.hedgeMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--timeout" && i + 1 < argc) {
+            params.coordinator.timeoutMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
         else {
             std::cerr << "Unknown option: " << arg << std::endl;
             return false;
@@ -152,7 +221,7 @@ uint16_t Calculator::calculateVectorSum(const std::vector<uint16_t>& vector) {
     return static_cast<uint16_t>(sum);
 }
 
-Server::Server() : logger(""), serverSocket(-1) {}
+Server::Server() : logger(""), serverSocket(-1), tracing(false) {}
 
 bool Server::parseCommandLine(int argc, char** argv) {
     return ::parseCommandLine(argc, argv, params);
@@ -179,7 +248,7 @@ bool Server::initializeSocket() {
         return false;
     }
     
-    if (listen(serverSocket, 5) < 0) {
+    if (listen(serverSocket, SOMAXCONN) < 0) {
         logger.logError("Failed to listen on socket", true);
         close(serverSocket);
         return false;
@@ -200,41 +269,61 @@ bool Server::authenticateClient(int clientSocket, std::string& clientLogin) {
     buffer[bytesRead] = '\0';
     std::string authMessage(buffer);
     
+    if (tracing) {
+        traceSession.authFrame.assign(buffer, bytesRead);
+    }
+    
     logger.logInfo("Received auth message, length: " + std::to_string(authMessage.length()));
     
     std::string login, salt, hash;
     
-    if (authMessage.find("user") == 0 && authMessage.length() >= 76) {
-        login = "user";
-        salt = authMessage.substr(4, 16);
-        hash = authMessage.substr(20, 56);
-        logger.logInfo("Detected client format: login(4) + salt(16) + hash(56) = 76 bytes");
-    }
-    else if (authMessage.length() == 80) {
+    // Длину 80 проверяем первой: логин "user" в стандартном формате дополнен
+    // пробелами до 8 байт и тоже начинается с "user"
+    if (authMessage.length() == 80) {
         login = authMessage.substr(0, 8);
         salt = authMessage.substr(8, 16);
         hash = authMessage.substr(24, 56);
         logger.logInfo("Detected standard format: login(8) + salt(16) + hash(56) = 80 bytes");
     }
+    else if (authMessage.find("user") == 0 && authMessage.length() >= 76) {
+        login = "user";
+        salt = authMessage.substr(4, 16);
+        hash = authMessage.substr(20, 56);
+        logger.logInfo("Detected client format: login(4) + salt(16) + hash(56) = 76 bytes");
+    }
     else {
         logger.logError("Unsupported auth message format, length: " + std::to_string(authMessage.length()));
-        send(clientSocket, "ERR", 3, 0);
+        send(clientSocket, "ERR", 3, MSG_NOSIGNAL);
         return false;
     }
     
     logger.logInfo("Auth attempt - Login: '" + login + "', Salt: " + salt);
     
     if (authDB.authenticate(login, "", salt, hash)) {
-        send(clientSocket, "OK", 2, 0);
+        send(clientSocket, "OK", 2, MSG_NOSIGNAL);
         logger.logInfo("Client authenticated: " + login);
         return true;
     } else {
-        send(clientSocket, "ERR", 3, 0);
+        send(clientSocket, "ERR", 3, MSG_NOSIGNAL);
         logger.logError("Authentication failed for: " + login);
         return false;
     }
 }
 
+// Читает хеш, предложенный клиентом, и отвечает, нужно ли досылать сам вектор.
+// true - сумма найдена в кэше и записана в sum.
+bool Server::answerHashOffer(int clientSocket, uint32_t vectorSize, uint64_t& offeredHash, uint16_t& sum) {
+    if (recv(clientSocket, &offeredHash, sizeof(offeredHash), MSG_WAITALL) != sizeof(offeredHash)) {
+        logger.logError("Failed to receive vector hash");
+        return false;
+    }
+    
+    bool hit = cache.lookup(offeredHash, vectorSize, sum);
+    char verdict = hit ? CACHE_HIT : CACHE_MISS;
+    send(clientSocket, &verdict, sizeof(verdict), MSG_NOSIGNAL);
+    return hit;
+}
+
 std::vector<uint16_t> Server::processVectors(int clientSocket) {
     std::vector<uint16_t> results;
     
@@ -260,9 +349,12 @@ std::vector<uint16_t> Server::processVectors(int clientSocket) {
             return results;
         }
         
+        bool hashOffered = (vectorSize & HASH_OFFER_FLAG) != 0;
+        vectorSize &= ~HASH_OFFER_FLAG;
+        
         logger.logInfo("Vector " + std::to_string(i + 1) + " size: " + std::to_string(vectorSize));
         
-        if (vectorSize > 1000000) {
+        if (vectorSize > params.maxVectorSize) {
             logger.logError("Vector size too large: " + std::to_string(vectorSize));
             return results;
         }
@@ -272,6 +364,22 @@ std::vector<uint16_t> Server::processVectors(int clientSocket) {
             return results;
         }
         
+        uint64_t offeredHash = 0;
+        uint16_t cachedSum = 0;
+        if (hashOffered && answerHashOffer(clientSocket, vectorSize, offeredHash, cachedSum)) {
+            // Данные не передавались: в трассу попадают только размер и хеш
+            if (tracing) {
+                TraceVector traced;
+                traced.size = vectorSize;
+                traced.kind = TraceVector::OFFER_HIT;
+                traced.hash = offeredHash;
+                tracer.writeVector(traced);
+            }
+            results.push_back(cachedSum);
+            logger.logInfo("Vector " + std::to_string(i + 1) + " sum (cached): " + std::to_string(cachedSum));
+            continue;
+        }
+        
         std::vector<uint16_t> vector(vectorSize);
         bytesRead = recv(clientSocket, vector.data(), vectorSize * sizeof(uint16_t), MSG_WAITALL);
         if (bytesRead != static_cast<ssize_t>(vectorSize * sizeof(uint16_t))) {
@@ -279,9 +387,43 @@ std::vector<uint16_t> Server::processVectors(int clientSocket) {
             return results;
         }
         
-        uint16_t sum = calculator.calculateVectorSum(vector);
+        uint16_t sum = 0;
+        std::vector<uint16_t> partials;
+        bool sharded = coordinator.enabled() && vectorSize > coordinator.shardSize();
+        if (sharded && coordinator.distribute(vector, partials)) {
+            // Насыщающее сложение частичных сумм даёт тот же результат, что и по всему вектору
+            sum = calculator.calculateVectorSum(partials);
+            logger.logInfo("Vector " + std::to_string(i + 1) + " summed across " +
+                           std::to_string(partials.size()) + " shards");
+        } else {
+            if (sharded) {
+                logger.logError("Sharded sum failed, computing vector " + std::to_string(i + 1) + " locally");
+            }
+            sum = calculator.calculateVectorSum(vector);
+        }
         results.push_back(sum);
         
+        // В кэш попадает только хеш, совпавший с пересчитанным по полученным данным:
+        // это отсекает ошибочный или небрежно посчитанный хеш клиента. От намеренной
+        // коллизии проверка не защищает - XXH64 без секретного ключа не криптостойкий
+        if (hashOffered && cache.enabled()) {
+            if (xxHash64(vector.data(), vectorSize * sizeof(uint16_t)) == offeredHash) {
+                cache.insert(offeredHash, vectorSize, sum);
+            } else {
+                logger.logError("Vector " + std::to_string(i + 1) + " does not match the offered hash");
+            }
+        }
+        
+        // Вектор уходит в трассу сразу и освобождается вместе с ней в конце итерации
+        if (tracing) {
+            TraceVector traced;
+            traced.size = vectorSize;
+            traced.kind = hashOffered ? TraceVector::OFFER_MISS : TraceVector::PLAIN;
+            traced.hash = offeredHash;
+            traced.data = std::move(vector);
+            tracer.writeVector(traced);
+        }
+        
         logger.logInfo("Vector " + std::to_string(i + 1) + " sum: " + std::to_string(sum));
     }
     
@@ -300,21 +442,35 @@ void Server::handleClient(int clientSocket) {
         strcpy(clientIP, "unknown");
     }
     
+    tracing = tracer.beginSession(traceSession);
+    
     std::string clientLogin;
-    if (!authenticateClient(clientSocket, clientLogin)) {
+    bool authorized = authenticateClient(clientSocket, clientLogin);
+    traceSession.authorized = authorized;
+    if (tracing) tracer.writeSession(traceSession);
+    if (!authorized) {
         close(clientSocket);
+        finishTrace();
         return;
     }
     
     std::vector<uint16_t> results = processVectors(clientSocket);
     
+    if (cache.enabled()) {
+        CacheStats stats = cache.stats();
+        std::ostringstream rate;
+        rate << std::fixed << std::setprecision(1) << stats.hitRate() * 100;
+        logger.logInfo("Cache: " + std::to_string(stats.hits) + " hits, " + std::to_string(stats.misses) +
+                       " misses, hit rate " + rate.str() + "%, " + std::to_string(stats.evictions) + " evictions");
+    }
+    
     if (!results.empty()) {
         uint32_t numResults = results.size();
-        if (send(clientSocket, &numResults, sizeof(numResults), 0) != sizeof(numResults)) {
+        if (send(clientSocket, &numResults, sizeof(numResults), MSG_NOSIGNAL) != sizeof(numResults)) {
             logger.logError("Failed to send result count");
         } else {
             for (uint16_t result : results) {
-                if (send(clientSocket, &result, sizeof(result), 0) != sizeof(result)) {
+                if (send(clientSocket, &result, sizeof(result), MSG_NOSIGNAL) != sizeof(result)) {
                     logger.logError("Failed to send result");
                     break;
                 }
@@ -327,6 +483,17 @@ void Server::handleClient(int clientSocket) {
     
     close(clientSocket);
     logger.logInfo("Client " + std::string(clientIP) + " disconnected");
+    finishTrace();
+}
+
+// Завершает запись сессии уже после ответа клиенту, чтобы сброс трассы на диск
+// не добавлялся к задержке, которую трасса и должна воспроизводить
+void Server::finishTrace() {
+    if (tracing && !tracer.endSession()) {
+        logger.logError("Failed to write session to trace file: " + params.traceFile);
+    }
+    tracing = false;
+    traceSession = TraceSession();
 }
 
 int Server::run(int argc, char** argv) {
@@ -340,6 +507,26 @@ int Server::run(int argc, char** argv) {
         return 1;
     }
     
+    if (!params.traceFile.empty()) {
+        if (!tracer.open(params.traceFile, params.traceSample)) {
+            logger.logError("Failed to open trace file: " + params.traceFile, true);
+            return 1;
+        }
+        logger.logInfo("Recording 1 of every " + std::to_string(params.traceSample) +
+                       " sessions to trace: " + params.traceFile);
+    }
+    
+    if (!params.coordinator.backends.empty() && !coordinator.configure(params.coordinator, &logger)) {
+        return 1;
+    }
+    if (params.cacheEntries > 0) {
+        cache.configure(params.cacheEntries);
+        logger.logInfo("Result cache enabled: " + std::to_string(params.cacheEntries) + " entries");
+    }
+    if (params.maxVectorSize == 0) {
+        params.maxVectorSize = coordinator.enabled() ? COORDINATOR_MAX_VECTOR_SIZE : LOCAL_MAX_VECTOR_SIZE;
+    }
+    
     if (!initializeSocket()) return 1;
     
     std::cout << "✓ Server started on port " << params.port << std::endl;
@@ -5,11 +5,19 @@
 #include <unordered_map>
 #include <vector>
 #include <cstdint>
+#include "trace.h"
+#include "coordinator.h"
+#include "cache.h"
 
 struct ServerParams {
     std::string authFile = "./vcalc.conf";
     std::string logFile = "./log/vcalc.log";
     uint16_t port = 33333;
+    std::string traceFile;
+    uint32_t traceSample = 1;
+    uint32_t maxVectorSize = 0;
+    uint32_t cacheEntries = 0;
+    CoordinatorParams coordinator;
 };
 
 class AuthDatabase {
@@ -45,13 +53,20 @@ private:
     AuthDatabase authDB;
     Logger logger;
     Calculator calculator;
+    ShardCoordinator coordinator;
+    ResultCache cache;
     int serverSocket;
+    TraceRecorder tracer;
+    TraceSession traceSession;
+    bool tracing;
     
     bool parseCommandLine(int argc, char** argv);
     bool initializeSocket();
     void handleClient(int clientSocket);
+    void finishTrace();
     bool authenticateClient(int clientSocket, std::string& clientLogin);
     std::vector<uint16_t> processVectors(int clientSocket);
+    bool answerHashOffer(int clientSocket, uint32_t vectorSize, uint64_t& offeredHash, uint16_t& sum);
     
 public:
     Server();
@@ -2,7 +2,18 @@
 #include <cassert>
 #include <vector>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <random>
 #include "server.h"
+#include "client_util.h"
 
 // Вспомогательные функции для тестирования
 class TestHelper {
@@ -20,8 +31,163 @@ public:
     }
 };
 
+// Упрощённый бэкенд для проверки координатора: принимает любую аутентификацию,
+// считает сумму одного вектора и может отвечать с задержкой или обрывать первые
+// failures запросов (пробы здоровья из одного элемента не в счёт)
+class FakeBackend {
+private:
+    int listenSocket;
+    uint16_t port;
+    int delayMs;
+    int failures;
+    std::atomic<bool> stopping;
+    std::thread worker;
+    
+    void serve() {
+        Calculator calculator;
+        while (!stopping) {
+            int client = accept(listenSocket, nullptr, nullptr);
+            if (client < 0) continue;
+            
+            char auth[256];
+            uint32_t header[2];
+            if (recv(client, auth, sizeof(auth), 0) > 0 && send(client, "OK", 2, 0) == 2 &&
+                recv(client, header, sizeof(header), MSG_WAITALL) == sizeof(header)) {
+                std::vector<uint16_t> vector(header[1]);
+                size_t bytes = vector.size() * sizeof(uint16_t);
+                bool received = recv(client, vector.data(), bytes, MSG_WAITALL) == static_cast<ssize_t>(bytes);
+                if (received && vector.size() > 1 && failures > 0) {
+                    failures--;
+                } else if (received) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+                    uint16_t sum = calculator.calculateVectorSum(vector);
+                    uint32_t count = 1;
+                    send(client, &count, sizeof(count), MSG_NOSIGNAL);
+                    send(client, &sum, sizeof(sum), MSG_NOSIGNAL);
+                }
+            }
+            close(client);
+        }
+    }
+    
+public:
+    FakeBackend(int delay = 0, int fail = 0)
+        : listenSocket(-1), port(0), delayMs(delay), failures(fail), stopping(false) {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(listenSocket, (sockaddr*)&addr, sizeof(addr));
+        listen(listenSocket, 16);
+        getsockname(listenSocket, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        worker = std::thread(&FakeBackend::serve, this);
+    }
+    
+    ~FakeBackend() {
+        stopping = true;
+        shutdown(listenSocket, SHUT_RDWR);
+        worker.join();
+        close(listenSocket);
+    }
+    
+    std::string address() const {
+        return "127.0.0.1:" + std::to_string(port);
+    }
+};
+
+// Настоящий сервер в дочернем процессе - чтобы падение от сигнала не роняло тесты
+class ServerProcess {
+private:
+    pid_t pid;
+    uint16_t port;
+    
+public:
+    ServerProcess(const std::string& authFile, const std::string& logFile) : pid(-1), port(0) {
+        int probe = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(probe, (sockaddr*)&addr, sizeof(addr));
+        getsockname(probe, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        close(probe);
+        
+        // Иначе дочерний процесс при freopen допечатает унаследованный буфер
+        // и в выводе через канал (CTest) строки результатов задвоятся
+        std::cout.flush();
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            freopen("/dev/null", "w", stdout);
+            std::string portArg = std::to_string(port);
+            const char* argv[] = {"server", "-p", portArg.c_str(), "-a", authFile.c_str(),
+                                  "-l", logFile.c_str(), nullptr};
+            Server server;
+            _exit(server.run(7, const_cast<char**>(argv)));
+        }
+        
+        // Ждём, пока сервер начнёт принимать соединения
+        for (int i = 0; i < 100 && alive(); i++) {
+            int sock = socket(AF_INET, SOCK_STREAM, 0);
+            bool ready = connect(sock, (sockaddr*)&addr, sizeof(addr)) == 0;
+            close(sock);
+            if (ready) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    
+    ~ServerProcess() {
+        if (alive()) kill(pid, SIGTERM);
+        if (pid > 0) waitpid(pid, nullptr, 0);
+    }
+    
+    bool alive() {
+        if (pid <= 0) return false;
+        if (waitpid(pid, nullptr, WNOHANG) == pid) pid = -1;
+        return pid > 0;
+    }
+    
+    std::string address() const {
+        return "127.0.0.1:" + std::to_string(port);
+    }
+    
+    // Сессия, брошенная клиентом после отправки векторов, - так координатор
+    // отменяет проигравший дублированный запрос
+    void abandonSession(const std::string& password) {
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(sock);
+            return;
+        }
+        
+        std::mt19937_64 rng(port);
+        std::string authFrame = buildAuthFrame("user", password, rng);
+        
+        char reply[2];
+        if (sendAll(sock, authFrame.data(), authFrame.size()) && recvAll(sock, reply, sizeof(reply))) {
+            uint32_t numVectors = 100;
+            sendAll(sock, &numVectors, sizeof(numVectors));
+            for (uint32_t i = 0; i < numVectors; i++) {
+                uint32_t size = 1;
+                uint16_t value = 1;
+                sendAll(sock, &size, sizeof(size));
+                sendAll(sock, &value, sizeof(value));
+            }
+        }
+        shutdown(sock, SHUT_RDWR);
+        close(sock);
+    }
+};
+
 // Тест 1: Calculator (самый надежный)
-void testCalculator() {
+bool testCalculator() {
     std::cout << "=== Тестирование Calculator ===\n";
     
     Calculator calculator;
@@ -72,10 +238,12 @@ void testCalculator() {
     } else {
         std::cout << "✗ Некоторые тесты Calculator не пройдены\n";
     }
+    
+    return allPassed;
 }
 
 // Тест 2: AuthDatabase (базовый)
-void testAuthDatabase() {
+bool testAuthDatabase() {
     std::cout << "\n=== Тестирование AuthDatabase ===\n";
     
     AuthDatabase authDB;
@@ -119,10 +287,12 @@ void testAuthDatabase() {
     } else {
         std::cout << "✗ Некоторые тесты AuthDatabase не пройдены\n";
     }
+    
+    return allPassed;
 }
 
 // Тест 3: Logger (базовый)
-void testLogger() {
+bool testLogger() {
     std::cout << "\n=== Тестирование Logger ===\n";
     
     std::string testLogFile = "test_log.log";
@@ -159,11 +329,13 @@ void testLogger() {
     } else {
         std::cout << "✗ Некоторые тесты Logger не пройдены\n";
     }
+    
+    return allPassed;
 }
 
 
 // Тест 5: Интеграционный тест
-void testIntegration() {
+bool testIntegration() {
     std::cout << "\n=== Интеграционный тест ===\n";
     
     bool allPassed = true;
@@ -216,10 +388,12 @@ void testIntegration() {
     } else {
         std::cout << "✗ Интеграционный тест не пройден\n";
     }
+    
+    return allPassed;
 }
 
 // Тест 6: Граничные условия
-void testEdgeCases() {
+bool testEdgeCases() {
     std::cout << "\n=== Тестирование граничных условий ===\n";
     
     Calculator calculator;
@@ -260,6 +434,299 @@ void testEdgeCases() {
     } else {
         std::cout << "✗ Некоторые граничные условия не обработаны\n";
     }
+    
+    return allPassed;
+}
+
+// Тест 7: Запись и чтение трассы
+bool testTrace() {
+    std::cout << "\n=== Тестирование TraceRecorder/TraceReader ===\n";
+    
+    std::string traceFile = "test_trace.bin";
+    bool allPassed = true;
+    
+    // Тест 1: Запись с выборкой каждой второй сессии
+    {
+        TraceRecorder recorder;
+        if (recorder.open(traceFile, 2)) {
+            std::cout << "✓ Запись трассы - PASSED\n";
+        } else {
+            std::cout << "✗ Запись трассы - FAILED\n";
+            allPassed = false;
+        }
+        for (int i = 0; i < 4; i++) {
+            TraceSession session;
+            if (recorder.beginSession(session)) {
+                session.authFrame = "user" + std::to_string(i);
+                session.authorized = i == 2;
+                TraceVector plain, miss, hit;
+                plain.size = 3;
+                plain.data.assign(3, static_cast<uint16_t>(i));
+                miss.size = 2;
+                miss.kind = TraceVector::OFFER_MISS;
+                miss.hash = 42;
+                miss.data = {1, 2};
+                hit.size = 7;
+                hit.kind = TraceVector::OFFER_HIT;
+                hit.hash = 99;
+                recorder.writeSession(session);
+                recorder.writeVector(plain);
+                recorder.writeVector(miss);
+                recorder.writeVector(hit);
+                recorder.endSession();
+            }
+        }
+    }
+    
+    // Тест 2: Чтение - должны остаться сессии 0 и 2
+    TraceReader reader;
+    TraceSession session;
+    std::vector<std::string> frames;
+    bool payloadOk = true;
+    if (reader.open(traceFile)) {
+        while (reader.next(session)) {
+            frames.push_back(session.authFrame);
+            payloadOk = payloadOk && session.authorized == (session.authFrame == "user2") &&
+                        session.vectors.size() == 3 &&
+                        session.vectors[0].kind == TraceVector::PLAIN && session.vectors[0].data.size() == 3 &&
+                        session.vectors[1].hash == 42 && session.vectors[1].data[1] == 2 &&
+                        session.vectors[2].kind == TraceVector::OFFER_HIT && session.vectors[2].size == 7 &&
+                        session.vectors[2].hash == 99 && session.vectors[2].data.empty();
+        }
+    }
+    if (frames.size() == 2 && frames[0] == "user0" && frames[1] == "user2" && payloadOk) {
+        std::cout << "✓ Чтение трассы и выборка - PASSED\n";
+    } else {
+        std::cout << "✗ Чтение трассы и выборка - FAILED\n";
+        allPassed = false;
+    }
+    
+    // Тест 3: Сессия, не попавшая в выборку, не удерживает данные предыдущей
+    {
+        TraceRecorder recorder;
+        TraceSession session;
+        bool sampled = recorder.open(traceFile, 2) && recorder.beginSession(session);
+        session.authFrame = "user0";
+        session.vectors.resize(1);
+        bool skipped = !recorder.beginSession(session);
+        if (sampled && skipped && session.authFrame.empty() && session.vectors.empty()) {
+            std::cout << "✓ Очистка сессии вне выборки - PASSED\n";
+        } else {
+            std::cout << "✗ Очистка сессии вне выборки - FAILED\n";
+            allPassed = false;
+        }
+    }
+    
+    // Тест 4: Файл без заголовка трассы отклоняется
+    TestHelper::createTestFile(traceFile, "not a trace");
+    TraceReader badReader;
+    if (!badReader.open(traceFile)) {
+        std::cout << "✓ Отклонение некорректного файла - PASSED\n";
+    } else {
+        std::cout << "✗ Отклонение некорректного файла - FAILED\n";
+        allPassed = false;
+    }
+    
+    TestHelper::removeTestFile(traceFile);
+    
+    if (allPassed) {
+        std::cout << "✓ Все тесты трассировки пройдены\n";
+    } else {
+        std::cout << "✗ Некоторые тесты трассировки не пройдены\n";
+    }
+    
+    return allPassed;
+}
+
+// Тест 8: Координатор распределённого суммирования
+bool testShardCoordinator() {
+    std::cout << "\n=== Тестирование ShardCoordinator ===\n";
+    
+    Logger logger("test_coordinator.log");
+    Calculator calculator;
+    bool allPassed = true;
+    
+    // Тест 1: Сумма по шардам совпадает с локальной, недоступный бэкенд обходится
+    {
+        FakeBackend first, second;
+        CoordinatorParams params;
+        params.backends = {first.address(), "127.0.0.1:1", second.address()};
+        params.shardSize = 1000;
+        params.timeoutMs = 500;
+        
+        ShardCoordinator coordinator;
+        std::vector<uint16_t> vector(10000);
+        for (size_t i = 0; i < vector.size(); i++) vector[i] = i % 7;
+        
+        std::vector<uint16_t> partials;
+        bool ok = coordinator.configure(params, &logger) && coordinator.distribute(vector, partials);
+        if (ok && partials.size() == 10 &&
+            calculator.calculateVectorSum(partials) == calculator.calculateVectorSum(vector)) {
+            std::cout << "✓ Сумма по шардам в обход недоступного бэкенда - PASSED\n";
+        } else {
+            std::cout << "✗ Сумма по шардам в обход недоступного бэкенда - FAILED\n";
+            allPassed = false;
+        }
+        
+        // Тест 2: Насыщение при сложении частичных сумм
+        std::vector<uint16_t> large(5000, 1000);
+        ok = coordinator.distribute(large, partials);
+        if (ok && calculator.calculateVectorSum(partials) == UINT16_MAX) {
+            std::cout << "✓ Насыщение частичных сумм - PASSED\n";
+        } else {
+            std::cout << "✗ Насыщение частичных сумм - FAILED\n";
+            allPassed = false;
+        }
+    }
+    
+    // Тест 3: Медленный шард дублируется на быстрый бэкенд
+    {
+        FakeBackend slow(1500), fast;
+        CoordinatorParams params;
+        params.backends = {slow.address(), fast.address()};
+        params.shardSize = 100;
+        params.hedgeMs = 20;
+        params.retries = 0;
+        
+        ShardCoordinator coordinator;
+        std::vector<uint16_t> vector(200, 3);
+        std::vector<uint16_t> partials;
+        bool configured = coordinator.configure(params, &logger);
+        
+        auto started = std::chrono::steady_clock::now();
+        bool ok = configured && coordinator.distribute(vector, partials);
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        
+        if (ok && calculator.calculateVectorSum(partials) == 600 && elapsed < std::chrono::milliseconds(1000)) {
+            std::cout << "✓ Дублирование медленного шарда - PASSED\n";
+        } else {
+            std::cout << "✗ Дублирование медленного шарда - FAILED\n";
+            allPassed = false;
+        }
+    }
+    
+    // Тест 4: Единственный бэкенд - повторы идут на него же после паузы
+    {
+        FakeBackend flaky(0, 2);
+        CoordinatorParams params;
+        params.backends = {flaky.address()};
+        params.shardSize = 100;
+        params.retries = 2;
+        params.retryBackoffMs = 10;
+        
+        ShardCoordinator coordinator;
+        std::vector<uint16_t> vector(100, 5);
+        std::vector<uint16_t> partials;
+        bool ok = coordinator.configure(params, &logger) && coordinator.distribute(vector, partials);
+        
+        if (ok && calculator.calculateVectorSum(partials) == 500) {
+            std::cout << "✓ Повтор на том же бэкенде - PASSED\n";
+        } else {
+            std::cout << "✗ Повтор на том же бэкенде - FAILED\n";
+            allPassed = false;
+        }
+    }
+    
+    // Тест 5: Отменённые координатором сессии не роняют настоящий сервер-бэкенд
+    {
+        TestHelper::createTestFile("test_backend_auth.txt", "user:P@ssW0rd\n");
+        ServerProcess backend("test_backend_auth.txt", "test_backend.log");
+        
+        for (int i = 0; i < 5; i++) {
+            backend.abandonSession("P@ssW0rd");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        CoordinatorParams params;
+        params.backends = {backend.address()};
+        params.shardSize = 1000;
+        params.timeoutMs = 500;
+        
+        ShardCoordinator coordinator;
+        std::vector<uint16_t> vector(3000, 2);
+        std::vector<uint16_t> partials;
+        bool alive = backend.alive();
+        bool ok = alive && coordinator.configure(params, &logger) && coordinator.distribute(vector, partials);
+        
+        if (ok && calculator.calculateVectorSum(partials) == 6000 && backend.alive()) {
+            std::cout << "✓ Бэкенд переживает отменённые сессии - PASSED\n";
+        } else {
+            std::cout << "✗ Бэкенд переживает отменённые сессии - FAILED\n";
+            allPassed = false;
+        }
+        
+        TestHelper::removeTestFile("test_backend_auth.txt");
+        TestHelper::removeTestFile("test_backend.log");
+    }
+    
+    TestHelper::removeTestFile("test_coordinator.log");
+    
+    if (allPassed) {
+        std::cout << "✓ Все тесты ShardCoordinator пройдены\n";
+    } else {
+        std::cout << "✗ Некоторые тесты ShardCoordinator не пройдены\n";
+    }
+    
+    return allPassed;
+}
+
+// Тест 9: xxHash64 и кэш результатов
+bool testResultCache() {
+    std::cout << "\n=== Тестирование ResultCache ===\n";
+    
+    bool allPassed = true;
+    
+    // Тест 1: Эталонные значения XXH64 (seed 0), в том числе для входа длиннее 32 байт
+    std::string longInput = "Nobody inspects the spammish repetition";
+    if (xxHash64("", 0) == 0xEF46DB3751D8E999ULL && xxHash64("abc", 3) == 0x44BC2CF5AD770999ULL &&
+        xxHash64(longInput.data(), longInput.size()) == 0xFBCEA83C8A378BF1ULL) {
+        std::cout << "✓ Эталонные значения xxHash64 - PASSED\n";
+    } else {
+        std::cout << "✗ Эталонные значения xxHash64 - FAILED\n";
+        allPassed = false;
+    }
+    
+    // Тест 2: Вытеснение давно не использованной записи
+    ResultCache cache;
+    cache.configure(2, 1);
+    uint16_t sum = 0;
+    cache.insert(1, 10, 100);
+    cache.insert(2, 10, 200);
+    bool firstHit = cache.lookup(1, 10, sum) && sum == 100;
+    cache.insert(3, 10, 300);
+    if (firstHit && !cache.lookup(2, 10, sum) && cache.lookup(1, 10, sum) && cache.lookup(3, 10, sum) && sum == 300) {
+        std::cout << "✓ Вытеснение LRU - PASSED\n";
+    } else {
+        std::cout << "✗ Вытеснение LRU - FAILED\n";
+        allPassed = false;
+    }
+    
+    // Тест 3: Длина входит в ключ, статистика попаданий
+    CacheStats stats = cache.stats();
+    if (!cache.lookup(1, 11, sum) && stats.hits == 3 && stats.misses == 1 && stats.evictions == 1) {
+        std::cout << "✓ Ключ по длине и статистика - PASSED\n";
+    } else {
+        std::cout << "✗ Ключ по длине и статистика - FAILED\n";
+        allPassed = false;
+    }
+    
+    // Тест 4: Выключенный кэш ничего не хранит
+    ResultCache disabled;
+    disabled.insert(1, 10, 100);
+    if (!disabled.enabled() && !disabled.lookup(1, 10, sum)) {
+        std::cout << "✓ Выключенный кэш - PASSED\n";
+    } else {
+        std::cout << "✗ Выключенный кэш - FAILED\n";
+        allPassed = false;
+    }
+    
+    if (allPassed) {
+        std::cout << "✓ Все тесты ResultCache пройдены\n";
+    } else {
+        std::cout << "✗ Некоторые тесты ResultCache не пройдены\n";
+    }
+    
+    return allPassed;
 }
 
 // Главная функция
@@ -268,21 +735,37 @@ int main() {
     std::cout << "========================================\n\n";
     
     try {
-        testCalculator();
+        bool allPassed = true;
+        
+        allPassed = testCalculator() && allPassed;
         std::cout << "----------------------------------------\n";
         
-        testAuthDatabase();
+        allPassed = testAuthDatabase() && allPassed;
         std::cout << "----------------------------------------\n";
         
-        testLogger();
+        allPassed = testLogger() && allPassed;
         std::cout << "----------------------------------------\n";
 
-        testIntegration();
+        allPassed = testIntegration() && allPassed;
         std::cout << "----------------------------------------\n";
         
-        testEdgeCases();
+        allPassed = testEdgeCases() && allPassed;
+        std::cout << "----------------------------------------\n";
+        
+        allPassed = testTrace() && allPassed;
+        std::cout << "----------------------------------------\n";
+        
+        allPassed = testShardCoordinator() && allPassed;
+        std::cout << "----------------------------------------\n";
+        
+        allPassed = testResultCache() && allPassed;
         
         std::cout << "\n========================================\n";
+        if (!allPassed) {
+            std::cout << "✗ ТЕСТИРОВАНИЕ ЗАВЕРШЕНО С ОШИБКАМИ\n";
+            std::cout << "========================================\n";
+            return 1;
+        }
         std::cout << "ТЕСТИРОВАНИЕ УСПЕШНО ЗАВЕРШЕНО!\n";
         std::cout << "Все основные компоненты server.cpp протестированы\n";
         std::cout << "========================================\n";
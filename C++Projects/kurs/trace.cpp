@@ -0,0 +1,145 @@
+#include "trace.h"
+#include <cstring>
+
+static const char TRACE_MAGIC[4] = {'V', 'C', 'T', 'R'};
+static const uint32_t TRACE_VERSION = 4;
+
+static const char RECORD_SESSION = 'S';
+static const char RECORD_VECTOR = 'V';
+static const char RECORD_END = 'E';
+
+// Ограничения те же, что и у сервера, - защита от битого файла
+static const uint32_t MAX_AUTH_FRAME = 255;
+static const uint32_t MAX_VECTORS = 1000;
+static const uint32_t MAX_VECTOR_SIZE = 500000000;
+
+template <typename T>
+static void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+TraceRecorder::TraceRecorder() : sampleEvery(1), sessionCounter(0) {}
+
+bool TraceRecorder::open(const std::string& filename, uint32_t sample) {
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    writeValue(file, TRACE_VERSION);
+    file.flush();
+
+    sampleEvery = sample == 0 ? 1 : sample;
+    sessionCounter = 0;
+    startTime = std::chrono::steady_clock::now();
+    return static_cast<bool>(file);
+}
+
+bool TraceRecorder::isOpen() const {
+    return file.is_open();
+}
+
+bool TraceRecorder::beginSession(TraceSession& session) {
+    session = TraceSession();
+    if (!file.is_open()) return false;
+
+    // Детерминированная выборка: записывается каждая sampleEvery-я сессия
+    bool sampled = (sessionCounter++ % sampleEvery) == 0;
+    if (!sampled) return false;
+
+    session.offsetUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+bool TraceRecorder::writeSession(const TraceSession& session) {
+    if (!file.is_open()) return false;
+
+    writeValue(file, RECORD_SESSION);
+    writeValue(file, session.offsetUs);
+
+    uint32_t authLen = session.authFrame.size();
+    writeValue(file, authLen);
+    file.write(session.authFrame.data(), authLen);
+    uint8_t authorized = session.authorized ? 1 : 0;
+    writeValue(file, authorized);
+    return static_cast<bool>(file);
+}
+
+bool TraceRecorder::writeVector(const TraceVector& vector) {
+    if (!file.is_open()) return false;
+
+    writeValue(file, RECORD_VECTOR);
+    writeValue(file, vector.size);
+    uint8_t kind = vector.kind;
+    writeValue(file, kind);
+    if (vector.kind != TraceVector::PLAIN) writeValue(file, vector.hash);
+    if (vector.kind != TraceVector::OFFER_HIT) {
+        file.write(reinterpret_cast<const char*>(vector.data.data()), vector.size * sizeof(uint16_t));
+    }
+    return static_cast<bool>(file);
+}
+
+bool TraceRecorder::endSession() {
+    if (!file.is_open()) return false;
+
+    writeValue(file, RECORD_END);
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+bool TraceReader::open(const std::string& filename) {
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[4];
+    uint32_t version;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        return false;
+    }
+    if (!readValue(file, version) || version != TRACE_VERSION) {
+        return false;
+    }
+    return true;
+}
+
+bool TraceReader::next(TraceSession& session) {
+    session = TraceSession();
+
+    char record;
+    if (!readValue(file, record) || record != RECORD_SESSION) return false;
+    if (!readValue(file, session.offsetUs)) return false;
+
+    uint32_t authLen;
+    if (!readValue(file, authLen) || authLen > MAX_AUTH_FRAME) return false;
+    session.authFrame.resize(authLen);
+    if (authLen > 0 && !file.read(&session.authFrame[0], authLen)) return false;
+
+    uint8_t authorized;
+    if (!readValue(file, authorized)) return false;
+    session.authorized = authorized != 0;
+
+    while (readValue(file, record) && record == RECORD_VECTOR) {
+        if (session.vectors.size() >= MAX_VECTORS) return false;
+        session.vectors.push_back(TraceVector());
+        TraceVector& vector = session.vectors.back();
+
+        uint8_t kind;
+        if (!readValue(file, vector.size) || vector.size > MAX_VECTOR_SIZE) return false;
+        if (!readValue(file, kind) || kind > TraceVector::OFFER_HIT) return false;
+        vector.kind = static_cast<TraceVector::Kind>(kind);
+
+        if (vector.kind != TraceVector::PLAIN && !readValue(file, vector.hash)) return false;
+        if (vector.kind == TraceVector::OFFER_HIT) continue;
+
+        vector.data.resize(vector.size);
+        if (!file.read(reinterpret_cast<char*>(vector.data.data()), vector.size * sizeof(uint16_t))) {
+            return false;
+        }
+    }
+    return static_cast<bool>(file) && record == RECORD_END;
+}
@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+// Формат файла трассы (порядок байт - как у хоста, как и в самом протоколе).
+// Сервер пишет сессию по частям, по мере обработки, и не держит её векторы в памяти:
+//   заголовок: "VCTR" + uint32 версия
+//   'S' начало сессии: uint64 смещение от начала записи (мкс) - момент, когда сервер
+//              начал обслуживать сессию, а не приход клиента: пока сервер занят
+//              предыдущим клиентом, новые ждут в очереди на accept
+//              uint32 длина auth-сообщения + байты auth-сообщения
+//              uint8 ответ сервера на аутентификацию (1 - OK, 0 - ERR)
+//   'V' вектор: uint32 размер + uint8 вид (TraceVector::Kind)
+//              uint64 предложенный хеш - для OFFER_MISS и OFFER_HIT
+//              размер * uint16 - кроме OFFER_HIT: данные не передавались
+//   'E' конец сессии - пишется после отправки ответа клиенту. Сессия без
+//              завершающей записи (сервер остановлен посреди неё) не читается
+struct TraceVector {
+    enum Kind : uint8_t { PLAIN = 0, OFFER_MISS = 1, OFFER_HIT = 2 };
+
+    uint32_t size = 0;
+    Kind kind = PLAIN;
+    uint64_t hash = 0;
+    std::vector<uint16_t> data;
+};
+
+struct TraceSession {
+    uint64_t offsetUs = 0;
+    std::string authFrame;
+    bool authorized = false;
+    std::vector<TraceVector> vectors;
+};
+
+class TraceRecorder {
+private:
+    std::ofstream file;
+    uint32_t sampleEvery;
+    uint64_t sessionCounter;
+    std::chrono::steady_clock::time_point startTime;
+
+public:
+    TraceRecorder();
+    bool open(const std::string& filename, uint32_t sample = 1);
+    bool isOpen() const;
+    bool beginSession(TraceSession& session);
+    bool writeSession(const TraceSession& session);
+    bool writeVector(const TraceVector& vector);
+    bool endSession();
+};
+
+class TraceReader {
+private:
+    std::ifstream file;
+
+public:
+    bool open(const std::string& filename);
+    bool next(TraceSession& session);
+};
+
+#endif